@@ -11,9 +11,6 @@
 #define PIT_PORT_CONTROL          0x43                /* Control port. */
 #define PIT_PORT_COUNTER(CHANNEL) (0x40 + (CHANNEL))  /* Counter port. */
 
-/* PIT cycles per second. */
-#define PIT_HZ 1193180
-
 /* Configure the given CHANNEL in the PIT.  In a PC, the PIT's
    three output channels are hooked up like this:
 
@@ -81,3 +78,48 @@ pit_configure_channel (int channel, int mode, int frequency)
   outb (PIT_PORT_COUNTER (channel), count >> 8);
   intr_set_level (old_level);
 }
+
+/* Starts CHANNEL counting down COUNT PIT cycles in mode 0,
+   "interrupt on terminal count": the channel's output goes low
+   now and rises, once, when the count runs out, raising a
+   single interrupt on channel 0.  The channel keeps counting
+   afterward but its output stays high until it is reprogrammed.
+   COUNT must be between 1 and 65536. */
+void
+pit_start_oneshot (int channel, unsigned count)
+{
+  enum intr_level old_level;
+
+  ASSERT (channel == 0);
+  ASSERT (count >= 1 && count <= 65536);
+
+  /* A count of 65536 is loaded as 0. */
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, (channel << 6) | 0x30 | (0 << 1));
+  outb (PIT_PORT_COUNTER (channel), count);
+  outb (PIT_PORT_COUNTER (channel), count >> 8);
+  intr_set_level (old_level);
+}
+
+/* Latches CHANNEL's status and count with the 8254 read-back
+   command, stores the count in *COUNT, and returns the state of
+   the channel's output.  In mode 0, a true return value means
+   that the count has already run out. */
+bool
+pit_read_back (int channel, unsigned *count)
+{
+  enum intr_level old_level;
+  uint8_t status, lo, hi;
+
+  ASSERT (channel == 0 || channel == 2);
+
+  old_level = intr_disable ();
+  outb (PIT_PORT_CONTROL, 0xc0 | (1 << (channel + 1)));
+  status = inb (PIT_PORT_COUNTER (channel));
+  lo = inb (PIT_PORT_COUNTER (channel));
+  hi = inb (PIT_PORT_COUNTER (channel));
+  intr_set_level (old_level);
+
+  *count = lo | (hi << 8);
+  return (status & 0x80) != 0;
+}
@@ -4,7 +4,12 @@
 #include "devices/kbd.h"
 #include "devices/serial.h"
 #include "devices/timer.h"
+#include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
@@ -130,11 +135,17 @@ print_stats (void)
 {
   timer_print_stats ();
   thread_print_stats ();
+  intr_print_stats ();
+  palloc_print_stats ();
+  malloc_print_stats ();
+  kmem_print_stats ();
 #ifdef FILESYS
   block_print_stats ();
 #endif
   console_print_stats ();
   kbd_print_stats ();
+  lock_profile_print ();
+  intr_trace_print ();
 #ifdef USERPROG
   exception_print_stats ();
 #endif
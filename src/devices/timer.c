@@ -1,6 +1,7 @@
 #include "devices/timer.h"
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stdio.h>
 #include "devices/pit.h"
@@ -20,11 +21,46 @@
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* List of threads blocked in timer_sleep(), ordered by
+   `wakeup_tick', earliest first.  Threads with equal wakeup
+   ticks stay in the order in which they went to sleep. */
+static struct list sleep_list;
+
+/* List of armed timer events, ordered by `expires', earliest
+   first. */
+static struct list event_list;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Tickless idle.
+
+   When the idle thread is about to halt, timer_idle_enter()
+   replaces the periodic PIT interrupt by a single one-shot
+   interrupt at the next sleeping thread's wakeup tick.  The PIT
+   counter is only 16 bits wide, so a one-shot covers at most
+   TICKLESS_MAX_TICKS ticks.  The first external interrupt after
+   that, whether from the timer or any other device, calls
+   timer_idle_exit(), which works out how many ticks went by,
+   replays them, and restores the periodic mode. */
+bool timer_tickless;
+
+/* PIT cycles per timer tick. */
+#define TICK_CYCLES ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Longest one-shot, in ticks, that fits in the PIT counter. */
+#define TICKLESS_MAX_TICKS (65536 / TICK_CYCLES)
+
+static unsigned oneshot_cycles;   /* Length of one-shot, 0 if periodic. */
+static unsigned oneshot_phase;    /* Cycles into the tick at its start. */
+static unsigned tickless_entries; /* # of one-shots programmed. */
+static int64_t tickless_ticks;    /* # of ticks skipped by one-shots. */
+
 static intr_handler_func timer_interrupt;
+static list_less_func wakeup_less;
+static list_less_func event_less;
+static void timer_advance (void);
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
@@ -35,6 +71,8 @@ static void real_time_delay (int64_t num, int32_t denom);
 void
 timer_init (void) 
 {
+  list_init (&sleep_list);
+  list_init (&event_list);
   pit_configure_channel (0, 2, TIMER_FREQ);
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
@@ -85,15 +123,78 @@ timer_elapsed (int64_t then)
 }
 
 /* Sleeps for approximately TICKS timer ticks.  Interrupts must
-   be turned on. */
+   be turned on.
+
+   The calling thread is blocked on the sleep list rather than
+   yielding in a loop, so it consumes no CPU time until
+   timer_interrupt() wakes it up. */
 void
 timer_sleep (int64_t ticks) 
 {
-  int64_t start = timer_ticks ();
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
 
   ASSERT (intr_get_level () == INTR_ON);
-  while (timer_elapsed (start) < ticks) 
-    thread_yield ();
+  if (ticks <= 0)
+    return;
+
+  old_level = intr_disable ();
+  cur->wakeup_tick = timer_ticks () + ticks;
+  list_insert_ordered (&sleep_list, &cur->elem, wakeup_less, NULL);
+  thread_block ();
+  intr_set_level (old_level);
+}
+
+/* Initializes timer event E to call FUNC when it fires. */
+void
+timer_event_init (struct timer_event *e, void (*func) (struct timer_event *))
+{
+  ASSERT (e != NULL);
+  ASSERT (func != NULL);
+
+  e->armed = false;
+  e->func = func;
+}
+
+/* Arms timer event E, which must not already be armed, to fire
+   from the timer interrupt at tick EXPIRES, or at the next tick
+   if EXPIRES has already passed.  May be called from an
+   interrupt handler. */
+void
+timer_event_add (struct timer_event *e, int64_t expires)
+{
+  enum intr_level old_level;
+
+  ASSERT (e != NULL);
+
+  old_level = intr_disable ();
+  ASSERT (!e->armed);
+  e->expires = expires;
+  e->armed = true;
+  list_insert_ordered (&event_list, &e->elem, event_less, NULL);
+  intr_set_level (old_level);
+}
+
+/* Disarms timer event E.  Returns true if E was armed, false if
+   it had already fired or was never armed.  May be called from
+   an interrupt handler. */
+bool
+timer_event_cancel (struct timer_event *e)
+{
+  enum intr_level old_level;
+  bool was_armed;
+
+  ASSERT (e != NULL);
+
+  old_level = intr_disable ();
+  was_armed = e->armed;
+  if (was_armed)
+    {
+      list_remove (&e->elem);
+      e->armed = false;
+    }
+  intr_set_level (old_level);
+  return was_armed;
 }
 
 /* Sleeps for approximately MS milliseconds.  Interrupts must be
@@ -164,16 +265,154 @@ void
 timer_print_stats (void) 
 {
   printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+  if (timer_tickless)
+    printf ("Timer: %u tickless idle periods, %"PRId64" ticks skipped\n",
+            tickless_entries, tickless_ticks);
 }
 
+/* Called by the idle thread, with interrupts off, just before
+   it halts.  If tickless idle is enabled and no thread needs to
+   wake up on the next tick, switches the PIT to a one-shot that
+   fires on the tick when the first sleeping thread is due, or
+   as late as the PIT allows if no thread is sleeping. */
+void
+timer_idle_enter (void)
+{
+  int64_t idle_ticks = TICKLESS_MAX_TICKS;
+  unsigned remaining;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!timer_tickless || oneshot_cycles != 0)
+    return;
+
+  if (!list_empty (&sleep_list))
+    {
+      struct thread *t = list_entry (list_front (&sleep_list),
+                                     struct thread, elem);
+      if (t->wakeup_tick - ticks < idle_ticks)
+        idle_ticks = t->wakeup_tick - ticks;
+    }
+  if (!list_empty (&event_list))
+    {
+      struct timer_event *e = list_entry (list_front (&event_list),
+                                          struct timer_event, elem);
+      if (e->expires - ticks < idle_ticks)
+        idle_ticks = e->expires - ticks;
+    }
+  if (idle_ticks <= 1)
+    return;
+
+  /* End the one-shot exactly where the periodic timer would have
+     raised its IDLE_TICKS'th interrupt: finish the current tick,
+     then run IDLE_TICKS - 1 more. */
+  pit_read_back (0, &remaining);
+  if (remaining == 0 || remaining > TICK_CYCLES)
+    remaining = TICK_CYCLES;
+  oneshot_phase = TICK_CYCLES - remaining;
+  oneshot_cycles = remaining + (idle_ticks - 1) * TICK_CYCLES;
+  pit_start_oneshot (0, oneshot_cycles);
+  tickless_entries++;
+}
+
+/* Called at the start of every external interrupt.  If the PIT
+   is in a tickless one-shot, replays the timer ticks that
+   elapsed during it and restores the periodic timer.  If the
+   one-shot ran out, its interrupt accounts for the final tick;
+   otherwise, some other device woke us up early, and the
+   partial tick in progress is dropped. */
+void
+timer_idle_exit (void)
+{
+  unsigned count, elapsed;
+  bool expired;
+  int64_t n;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (oneshot_cycles == 0)
+    return;
+
+  expired = pit_read_back (0, &count);
+  if (expired)
+    elapsed = oneshot_cycles - TICK_CYCLES;
+  else
+    elapsed = count <= oneshot_cycles ? oneshot_cycles - count : 0;
+  n = (oneshot_phase + elapsed) / TICK_CYCLES;
+
+  oneshot_cycles = 0;
+  pit_configure_channel (0, 2, TIMER_FREQ);
+
+  tickless_ticks += n;
+  while (n-- > 0)
+    timer_advance ();
+}
+
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED)
+{
+  timer_advance ();
+  thread_check_preempt ();
+}
+
+/* Advances the clock by one tick.  Wakes up every sleeping
+   thread whose wakeup tick has arrived.  Because the sleep list
+   is sorted, this only touches the threads that actually
+   expire. */
+static void
+timer_advance (void)
 {
   ticks++;
+
+  while (!list_empty (&sleep_list))
+    {
+      struct thread *t = list_entry (list_front (&sleep_list),
+                                     struct thread, elem);
+      if (t->wakeup_tick > ticks)
+        break;
+      list_pop_front (&sleep_list);
+      thread_unblock (t);
+    }
+
+  while (!list_empty (&event_list))
+    {
+      struct timer_event *e = list_entry (list_front (&event_list),
+                                          struct timer_event, elem);
+      if (e->expires > ticks)
+        break;
+      list_pop_front (&event_list);
+      e->armed = false;
+      e->func (e);
+    }
+
   thread_tick ();
 }
 
+/* Returns true if thread A, on the sleep list, should wake up
+   strictly before thread B. */
+static bool
+wakeup_less (const struct list_elem *a_, const struct list_elem *b_,
+             void *aux UNUSED)
+{
+  const struct thread *a = list_entry (a_, struct thread, elem);
+  const struct thread *b = list_entry (b_, struct thread, elem);
+
+  return a->wakeup_tick < b->wakeup_tick;
+}
+
+/* Returns true if timer event A should fire strictly before
+   timer event B. */
+static bool
+event_less (const struct list_elem *a_, const struct list_elem *b_,
+            void *aux UNUSED)
+{
+  const struct timer_event *a = list_entry (a_, struct timer_event, elem);
+  const struct timer_event *b = list_entry (b_, struct timer_event, elem);
+
+  return a->expires < b->expires;
+}
+
 /* Returns true if LOOPS iterations waits for more than one timer
    tick, otherwise false. */
 static bool
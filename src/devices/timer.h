@@ -1,12 +1,18 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* If true, stop the periodic tick while the CPU is idle.
+   Controlled by kernel command-line option "-tickless". */
+extern bool timer_tickless;
+
 void timer_init (void);
 void timer_calibrate (void);
 
@@ -24,6 +30,25 @@ void timer_mdelay (int64_t milliseconds);
 void timer_udelay (int64_t microseconds);
 void timer_ndelay (int64_t nanoseconds);
 
+/* A function to call from the timer interrupt at a given tick.
+   Called with interrupts off, in interrupt context. */
+struct timer_event
+  {
+    struct list_elem elem;      /* Element in the event list. */
+    int64_t expires;            /* Tick at which to call FUNC. */
+    bool armed;                 /* On the event list? */
+    void (*func) (struct timer_event *);
+  };
+
+void timer_event_init (struct timer_event *,
+                       void (*func) (struct timer_event *));
+void timer_event_add (struct timer_event *, int64_t expires);
+bool timer_event_cancel (struct timer_event *);
+
+/* Tickless idle. */
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
 void timer_print_stats (void);
 
 #endif /* devices/timer.h */
@@ -0,0 +1,29 @@
+#ifndef __LIB_INTRSTAT_H
+#define __LIB_INTRSTAT_H
+
+#include <stdint.h>
+
+/* Number of interrupt vectors. */
+#define INTRSTAT_VECTORS 256
+
+/* Maximum length of an interrupt's name, not counting the null
+   terminator.  Longer names are truncated. */
+#define INTRSTAT_NAME_MAX 31
+
+/* Statistics for one interrupt vector, as filled in by the
+   intrstat() system call and printed at shutdown.  Handler
+   cycles are measured with the time-stamp counter around the
+   call to the registered handler.  For internal interrupts whose
+   handlers may sleep, such as system calls, they include the
+   time spent asleep, and invocations that never return, such as
+   the exit system call, are not counted. */
+struct intrstat
+  {
+    char name[INTRSTAT_NAME_MAX + 1];   /* Name given at registration. */
+    uint64_t count;                     /* Number of invocations. */
+    uint64_t total_cycles;              /* Cycles spent in handler. */
+    uint64_t max_cycles;                /* Longest single invocation. */
+    unsigned yields;                    /* intr_yield_on_return() requests. */
+  };
+
+#endif /* lib/intrstat.h */
@@ -0,0 +1,204 @@
+/* Priority queue.
+
+   See heap.h for basic information.
+
+   A pairing heap is a heap-ordered multiway tree.  Each element
+   points to its leftmost child and to its siblings; the leftmost
+   child's `prev' points to its parent instead, so that an
+   element can be unlinked from anywhere in the tree in O(1).
+   Two heaps are combined ("melded") by making the root that
+   should come out later the leftmost child of the other.
+   Removing the root melds its children in two passes, first in
+   pairs from left to right and then the pairs from right to
+   left, which gives the amortized O(log n) bound. */
+
+#include "heap.h"
+#include "../debug.h"
+
+/* Returns true if A should come out of heap H before B, breaking
+   ties by insertion order. */
+static bool
+before (const struct heap *h,
+        const struct heap_elem *a, const struct heap_elem *b)
+{
+  if (h->less (a, b, h->aux))
+    return true;
+  else if (h->less (b, a, h->aux))
+    return false;
+  else
+    return (int) (a->seq - b->seq) < 0;
+}
+
+/* Melds the trees rooted at A and B, either of which may be
+   null, and returns the root of the result.  A and B must not
+   have siblings. */
+static struct heap_elem *
+meld (const struct heap *h, struct heap_elem *a, struct heap_elem *b)
+{
+  if (a == NULL)
+    return b;
+  if (b == NULL)
+    return a;
+  if (before (h, b, a))
+    {
+      struct heap_elem *t = a;
+      a = b;
+      b = t;
+    }
+
+  b->prev = a;
+  b->next = a->child;
+  if (a->child != NULL)
+    a->child->prev = b;
+  a->child = b;
+  return a;
+}
+
+/* Melds the sibling list that starts at FIRST into a single
+   tree and returns its root, or null if FIRST is null. */
+static struct heap_elem *
+merge_siblings (const struct heap *h, struct heap_elem *first)
+{
+  struct heap_elem *pairs = NULL;
+  struct heap_elem *root = NULL;
+
+  /* First pass: meld adjacent pairs from left to right, pushing
+     each result onto PAIRS, which is linked through `next'. */
+  while (first != NULL)
+    {
+      struct heap_elem *a = first;
+      struct heap_elem *b = a->next;
+
+      first = b != NULL ? b->next : NULL;
+      a->prev = a->next = NULL;
+      if (b != NULL)
+        b->prev = b->next = NULL;
+
+      a = meld (h, a, b);
+      a->next = pairs;
+      pairs = a;
+    }
+
+  /* Second pass: meld the pairs from right to left. */
+  while (pairs != NULL)
+    {
+      struct heap_elem *a = pairs;
+
+      pairs = a->next;
+      a->next = NULL;
+      root = meld (h, root, a);
+    }
+  return root;
+}
+
+/* Links E, whose `seq' is already set, into heap H. */
+static void
+link_elem (struct heap *h, struct heap_elem *e)
+{
+  e->child = e->next = e->prev = NULL;
+  h->root = meld (h, h->root, e);
+  h->size++;
+}
+
+/* Initializes H as an empty heap that orders its elements with
+   LESS, given auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux)
+{
+  ASSERT (h != NULL);
+  ASSERT (less != NULL);
+
+  h->root = NULL;
+  h->size = 0;
+  h->next_seq = 0;
+  h->less = less;
+  h->aux = aux;
+}
+
+/* Inserts E into H. */
+void
+heap_insert (struct heap *h, struct heap_elem *e)
+{
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+
+  e->seq = h->next_seq++;
+  link_elem (h, e);
+}
+
+/* Returns the element at the top of H, that is, the one that
+   heap_pop() would remove, without removing it.  Returns a null
+   pointer if H is empty. */
+struct heap_elem *
+heap_top (const struct heap *h)
+{
+  ASSERT (h != NULL);
+
+  return h->root;
+}
+
+/* Removes and returns the element at the top of H, or returns a
+   null pointer if H is empty. */
+struct heap_elem *
+heap_pop (struct heap *h)
+{
+  struct heap_elem *e = h->root;
+
+  if (e != NULL)
+    heap_remove (h, e);
+  return e;
+}
+
+/* Removes E, which must be in H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e)
+{
+  struct heap_elem *sub;
+
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+  ASSERT (h->size > 0);
+
+  if (e == h->root)
+    h->root = NULL;
+  else
+    {
+      /* Unlink E from its parent or from its left sibling. */
+      if (e->prev->child == e)
+        e->prev->child = e->next;
+      else
+        e->prev->next = e->next;
+      if (e->next != NULL)
+        e->next->prev = e->prev;
+    }
+
+  sub = merge_siblings (h, e->child);
+  h->root = meld (h, h->root, sub);
+  h->size--;
+
+  e->child = e->next = e->prev = NULL;
+}
+
+/* Restores the heap order of H after the key of E, which must be
+   in H, has changed in either direction.  E keeps its place
+   among elements that compare equal to it. */
+void
+heap_update (struct heap *h, struct heap_elem *e)
+{
+  heap_remove (h, e);
+  link_elem (h, e);
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (const struct heap *h)
+{
+  return h->size;
+}
+
+/* Returns true if H is empty, false otherwise. */
+bool
+heap_empty (const struct heap *h)
+{
+  return h->root == NULL;
+}
@@ -0,0 +1,74 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Priority queue.
+
+   This is an intrusive pairing heap.  Like the linked list and
+   hash table, it does no dynamic allocation: each structure that
+   can be in a heap embeds a struct heap_elem member, and the
+   heap_entry macro converts a struct heap_elem back to the
+   structure that contains it.  Refer to lib/kernel/list.h for a
+   detailed explanation of the technique.
+
+   The heap keeps the "least" element, as defined by a caller-
+   supplied comparison function, at the top.  heap_top() is
+   O(1), heap_insert() is O(1), and heap_pop() and heap_remove()
+   are O(log n) amortized.
+
+   The heap is stable: among elements that compare equal, the
+   one inserted first comes out first.  heap_update() keeps an
+   element's original insertion order, so an element whose key
+   changes while it is in the heap does not lose its place among
+   equals. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem
+  {
+    struct heap_elem *child;    /* Leftmost child. */
+    struct heap_elem *next;     /* Next sibling. */
+    struct heap_elem *prev;     /* Previous sibling, or parent if
+                                   this is the leftmost child. */
+    unsigned seq;               /* Insertion order, for stability. */
+  };
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+        ((STRUCT *) ((uint8_t *) (HEAP_ELEM)            \
+                     - offsetof (STRUCT, MEMBER)))
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A should come out of the
+   heap before B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+                             const struct heap_elem *b,
+                             void *aux);
+
+/* Heap. */
+struct heap
+  {
+    struct heap_elem *root;     /* Top element, or null if empty. */
+    size_t size;                /* Number of elements. */
+    unsigned next_seq;          /* Next insertion sequence number. */
+    heap_less_func *less;       /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `less'. */
+  };
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+void heap_insert (struct heap *, struct heap_elem *);
+struct heap_elem *heap_top (const struct heap *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_update (struct heap *, struct heap_elem *);
+
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
@@ -0,0 +1,24 @@
+#ifndef __LIB_SCHEDSTAT_H
+#define __LIB_SCHEDSTAT_H
+
+#include <stdint.h>
+
+/* Number of buckets in the wakeup latency histogram.  Bucket 0
+   counts wakeups that ran within 1 TSC cycle; bucket N > 0
+   counts those that waited 2**N to 2**(N+1) - 1 cycles.  The
+   last bucket also counts anything longer. */
+#define SCHEDSTAT_BUCKETS 32
+
+/* Scheduler statistics for the calling thread, plus the
+   system-wide wakeup latency histogram, as filled in by the
+   schedstat() system call and printed at shutdown. */
+struct schedstat
+  {
+    uint64_t run_cycles;                /* Cycles spent running. */
+    uint64_t wait_cycles;               /* Cycles spent ready, not running. */
+    unsigned voluntary_switches;        /* Switches away by blocking. */
+    unsigned involuntary_switches;      /* Switches away while runnable. */
+    unsigned latency_hist[SCHEDSTAT_BUCKETS]; /* Wakeup-to-run latency. */
+  };
+
+#endif /* lib/schedstat.h */
@@ -28,7 +28,14 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_SCHEDSTAT,              /* Reads scheduler statistics. */
+    SYS_FUTEX_WAIT,             /* Sleeps while a word holds a value. */
+    SYS_FUTEX_WAKE,             /* Wakes threads sleeping on a word. */
+    SYS_INTRSTAT,               /* Reads interrupt statistics. */
+    SYS_SET_DEADLINE            /* Joins or leaves EDF scheduling. */
   };
 
 #endif /* lib/syscall-nr.h */
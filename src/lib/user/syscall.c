@@ -182,3 +182,33 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+bool
+schedstat (struct schedstat *st)
+{
+  return syscall1 (SYS_SCHEDSTAT, st);
+}
+
+int
+futex_wait (int *addr, int expected)
+{
+  return syscall2 (SYS_FUTEX_WAIT, addr, expected);
+}
+
+int
+futex_wake (int *addr, int n)
+{
+  return syscall2 (SYS_FUTEX_WAKE, addr, n);
+}
+
+bool
+intrstat (int vec, struct intrstat *st)
+{
+  return syscall2 (SYS_INTRSTAT, vec, st);
+}
+
+bool
+set_deadline (int period, int budget)
+{
+  return syscall2 (SYS_SET_DEADLINE, period, budget);
+}
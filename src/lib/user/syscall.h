@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <intrstat.h>
+#include <schedstat.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -45,4 +47,11 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+bool schedstat (struct schedstat *);
+int futex_wait (int *addr, int expected);
+int futex_wake (int *addr, int n);
+bool intrstat (int vec, struct intrstat *);
+bool set_deadline (int period, int budget);
+
 #endif /* lib/user/syscall.h */
@@ -0,0 +1,70 @@
+/* Puts a large number of threads to sleep at once and measures
+   how much of the sleep interval the CPU spends in the idle
+   thread.  Sleeping threads must be blocked, not spinning on
+   thread_yield(), so nearly the whole interval should be idle. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Number of sleeping threads. */
+#define SLEEPER_CNT 128
+
+/* Ticks that each sleeper sleeps. */
+#define SLEEP_TICKS 200
+
+static thread_func sleeper;
+
+void
+test_alarm_idle (void)
+{
+  struct semaphore done;
+  int64_t start_ticks, elapsed;
+  long long start_idle, idle;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("Creating %d threads to sleep %d ticks each.",
+       SLEEPER_CNT, SLEEP_TICKS);
+
+  sema_init (&done, 0);
+  for (i = 0; i < SLEEPER_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "sleeper %d", i);
+      thread_create (name, PRI_DEFAULT, sleeper, &done);
+    }
+
+  /* Let every sleeper go to sleep, then measure while they
+     sleep.  The main thread sleeps too. */
+  timer_sleep (2);
+  start_ticks = timer_ticks ();
+  start_idle = thread_get_idle_ticks ();
+  timer_sleep (SLEEP_TICKS / 2);
+  elapsed = timer_elapsed (start_ticks);
+  idle = thread_get_idle_ticks () - start_idle;
+
+  for (i = 0; i < SLEEPER_CNT; i++)
+    sema_down (&done);
+
+  msg ("%lld of %lld ticks idle (%lld%%) while %d threads slept.",
+       idle, (long long) elapsed, idle * 100 / elapsed, SLEEPER_CNT);
+  if (idle * 2 < elapsed)
+    fail ("sleeping threads kept the CPU busy");
+  pass ();
+}
+
+/* Sleeper thread. */
+static void
+sleeper (void *done_)
+{
+  struct semaphore *done = done_;
+
+  timer_sleep (SLEEP_TICKS);
+  sema_up (done);
+}
@@ -0,0 +1,108 @@
+/* malloc() benchmark.
+
+   First measures a malloc() immediately followed by free() of
+   the same size, for each size class, which the per-thread
+   magazines should serve without locking and without going to
+   the page allocator.  Prints one line per size of the form
+     bench malloc size=N ops=N cycles=N cycles_per_op=N
+
+   Then runs several threads at once, each of which repeatedly
+   allocates a batch of blocks of mixed sizes, fills each with a
+   pattern, checks the patterns, and frees them, so that blocks
+   move between magazines and descriptors and arenas are created
+   and released.  Fails if any block is overwritten while in use. */
+
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Sizes for the malloc()/free() loop. */
+static const size_t sizes[] = { 16, 32, 64, 128, 256, 512, 1024 };
+#define SIZE_CNT (sizeof sizes / sizeof *sizes)
+
+/* Iterations of the malloc()/free() loop per size. */
+#define OPS 10000
+
+/* Threads, rounds per thread, and blocks per round for the
+   concurrent test. */
+#define THREAD_CNT 4
+#define ROUNDS 50
+#define BATCH_CNT 100
+
+static thread_func batcher;
+static struct semaphore done;
+static int errors;
+
+void
+test_bench_malloc (void)
+{
+  size_t i;
+  int j;
+
+  for (i = 0; i < SIZE_CNT; i++)
+    {
+      uint64_t start, cycles;
+
+      start = rdtsc ();
+      for (j = 0; j < OPS; j++)
+        free (malloc (sizes[i]));
+      cycles = rdtsc () - start;
+      msg ("bench malloc size=%zu ops=%d cycles=%llu cycles_per_op=%llu",
+           sizes[i], OPS, cycles, cycles / OPS);
+    }
+
+  sema_init (&done, 0);
+  for (j = 0; j < THREAD_CNT; j++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "batcher %d", j);
+      thread_create (name, PRI_DEFAULT, batcher, (void *) j);
+    }
+  for (j = 0; j < THREAD_CNT; j++)
+    sema_down (&done);
+
+  if (errors != 0)
+    fail ("%d blocks corrupted", errors);
+  pass ();
+}
+
+/* Allocates, checks, and frees batches of blocks. */
+static void
+batcher (void *id_)
+{
+  int id = (int) id_;
+  uint8_t *blocks[BATCH_CNT];
+  size_t lens[BATCH_CNT];
+  int round, i;
+
+  for (round = 0; round < ROUNDS; round++)
+    {
+      for (i = 0; i < BATCH_CNT; i++)
+        {
+          lens[i] = 1 + random_ulong () % 1024;
+          blocks[i] = malloc (lens[i]);
+          if (blocks[i] != NULL)
+            memset (blocks[i], id * BATCH_CNT + i, lens[i]);
+          if (i % 10 == 0)
+            thread_yield ();
+        }
+      for (i = 0; i < BATCH_CNT; i++)
+        if (blocks[i] != NULL)
+          {
+            size_t k;
+            for (k = 0; k < lens[i]; k++)
+              if (blocks[i][k] != (uint8_t) (id * BATCH_CNT + i))
+                {
+                  errors++;
+                  break;
+                }
+            free (blocks[i]);
+          }
+    }
+  sema_up (&done);
+}
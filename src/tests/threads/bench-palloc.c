@@ -0,0 +1,286 @@
+/* Page allocator benchmark.
+
+   Runs the same random sequence of multi-page allocations and
+   frees, with sizes from 1 to 16 pages, against two allocators
+   that manage pools of the same number of pages: palloc's own
+   buddy allocator, on a private pool carved out of the kernel
+   pool, and a simulated first-fit bitmap scan, the way palloc
+   used to allocate.  Neither takes a lock, disables interrupts,
+   or fills freed pages, so the cycle counts compare only the
+   algorithms.
+
+   Prints one line per allocator of the form
+     bench palloc-NAME ops=N alloc_cycles=N free_cycles=N failed=N
+       largest_free=N
+   where the cycles are per operation and largest_free is the
+   largest number of pages that a single allocation could still
+   obtain at the end of the sequence, found the same way for
+   both allocators: by binary search over trial allocations.
+
+   Then runs the sequence once more through palloc_get_multiple()
+   on the kernel pool.  Fails if either palloc pool does not get
+   back every page, merged into blocks as large as before, once
+   everything has been freed. */
+
+#include <bitmap.h>
+#include <random.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Pages taken from the kernel pool for the private pool,
+   including the pool's header and metadata, which leave 384
+   pages to allocate.  Not a power of 2, so that the pool starts
+   out as blocks of several sizes, like the kernel pool. */
+#define REGION_PAGES 386
+
+/* Number of allocations that may be live at once. */
+#define SLOT_CNT 128
+
+/* Number of allocations or frees. */
+#define OPS 20000
+
+/* Random number seed. */
+#define SEED 0x5eed
+
+/* A live allocation. */
+struct slot
+  {
+    size_t page_cnt;            /* 0 if slot is empty. */
+    size_t page_idx;            /* Bitmap allocator. */
+    void *pages;                /* palloc. */
+  };
+
+/* Results of one run. */
+struct result
+  {
+    uint64_t alloc_cycles, free_cycles;
+    int allocs, frees, failed;
+    size_t largest_free;
+  };
+
+static struct slot slots[SLOT_CNT];
+
+/* Number of pages that each allocator manages. */
+static size_t pool_pages;
+
+/* Pages in use in the simulated bitmap pool. */
+static struct bitmap *used_map;
+
+/* Returns a random allocation size: half single pages, a quarter
+   2 to 4 pages, and a quarter 5 to 16 pages. */
+static size_t
+random_size (void)
+{
+  unsigned long r = random_ulong ();
+
+  switch (r % 4)
+    {
+    case 0:
+    case 1:
+      return 1;
+    case 2:
+      return 2 + r / 4 % 3;
+    default:
+      return 5 + r / 4 % 12;
+    }
+}
+
+/* Allocator under test. */
+struct allocator
+  {
+    const char *name;
+    void (*init) (void);
+    bool (*alloc) (struct slot *);
+    void (*free) (struct slot *);
+  };
+
+/* palloc's buddy allocator, on a private pool. */
+static struct pool *buddy_pool;
+
+static bool
+buddy_alloc (struct slot *s)
+{
+  s->pages = palloc_pool_get (buddy_pool, s->page_cnt);
+  return s->pages != NULL;
+}
+
+static void
+buddy_free (struct slot *s)
+{
+  palloc_pool_free (buddy_pool, s->pages, s->page_cnt);
+}
+
+/* Simulated first-fit bitmap allocator. */
+static void
+bitmap_init (void)
+{
+  bitmap_set_all (used_map, false);
+}
+
+static bool
+bitmap_alloc (struct slot *s)
+{
+  s->page_idx = bitmap_scan_and_flip (used_map, 0, s->page_cnt, false);
+  return s->page_idx != BITMAP_ERROR;
+}
+
+static void
+bitmap_free (struct slot *s)
+{
+  bitmap_set_multiple (used_map, s->page_idx, s->page_cnt, false);
+}
+
+/* palloc's kernel pool. */
+static bool
+palloc_alloc (struct slot *s)
+{
+  s->pages = palloc_get_multiple (0, s->page_cnt);
+  return s->pages != NULL;
+}
+
+static void
+palloc_free (struct slot *s)
+{
+  palloc_free_multiple (s->pages, s->page_cnt);
+}
+
+/* Returns the largest number of pages, up to pool_pages, that A
+   can allocate at once, by binary search over trial allocations,
+   each freed right away. */
+static size_t
+largest_free (const struct allocator *a)
+{
+  size_t lo = 0, hi = pool_pages;
+
+  while (lo < hi)
+    {
+      struct slot s;
+
+      s.page_cnt = (lo + hi + 1) / 2;
+      if (a->alloc (&s))
+        {
+          a->free (&s);
+          lo = s.page_cnt;
+        }
+      else
+        hi = s.page_cnt - 1;
+    }
+  return lo;
+}
+
+/* Runs the benchmark sequence against A, frees everything it
+   left allocated, and returns the results in *R. */
+static void
+run (const struct allocator *a, struct result *r)
+{
+  int i;
+
+  r->alloc_cycles = r->free_cycles = 0;
+  r->allocs = r->frees = r->failed = 0;
+  if (a->init != NULL)
+    a->init ();
+
+  random_init (SEED);
+  for (i = 0; i < OPS; i++)
+    {
+      struct slot *s = &slots[random_ulong () % SLOT_CNT];
+      uint64_t start;
+
+      if (s->page_cnt == 0)
+        {
+          bool ok;
+
+          s->page_cnt = random_size ();
+          start = rdtsc ();
+          ok = a->alloc (s);
+          r->alloc_cycles += rdtsc () - start;
+          r->allocs++;
+          if (!ok)
+            {
+              s->page_cnt = 0;
+              r->failed++;
+            }
+        }
+      else
+        {
+          start = rdtsc ();
+          a->free (s);
+          r->free_cycles += rdtsc () - start;
+          r->frees++;
+          s->page_cnt = 0;
+        }
+    }
+  r->largest_free = largest_free (a);
+
+  for (i = 0; i < SLOT_CNT; i++)
+    if (slots[i].page_cnt != 0)
+      {
+        a->free (&slots[i]);
+        slots[i].page_cnt = 0;
+      }
+}
+
+/* Runs the benchmark sequence against A and reports the
+   results. */
+static void
+bench (const struct allocator *a)
+{
+  struct result r;
+
+  run (a, &r);
+  msg ("bench palloc-%s ops=%d alloc_cycles=%llu free_cycles=%llu "
+       "failed=%d largest_free=%zu",
+       a->name, OPS, r.alloc_cycles / r.allocs, r.free_cycles / r.frees,
+       r.failed, r.largest_free);
+}
+
+void
+test_bench_palloc (void)
+{
+  static const struct allocator buddy =
+    { "buddy", NULL, buddy_alloc, buddy_free };
+  static const struct allocator first_fit =
+    { "bitmap", bitmap_init, bitmap_alloc, bitmap_free };
+  static const struct allocator real =
+    { "palloc", NULL, palloc_alloc, palloc_free };
+  struct palloc_stats before, after;
+  struct result r;
+  void *region;
+
+  region = palloc_get_multiple (0, REGION_PAGES);
+  if (region == NULL)
+    fail ("out of memory for private pool");
+  buddy_pool = palloc_create_pool (region, REGION_PAGES, "bench pool");
+  palloc_pool_get_stats (buddy_pool, &before);
+  pool_pages = before.page_cnt;
+  used_map = bitmap_create (pool_pages);
+  if (used_map == NULL)
+    fail ("out of memory for bitmap");
+
+  bench (&buddy);
+  bench (&first_fit);
+
+  palloc_pool_get_stats (buddy_pool, &after);
+  msg ("bench palloc-buddy splits=%llu merges=%llu",
+       after.split_cnt - before.split_cnt,
+       after.merge_cnt - before.merge_cnt);
+  if (after.free_cnt != pool_pages
+      || after.largest_free != before.largest_free)
+    fail ("private pool did not merge back to its starting blocks");
+  bitmap_destroy (used_map);
+  palloc_free_multiple (region, REGION_PAGES);
+
+  palloc_get_stats (0, &before);
+  run (&real, &r);
+  palloc_get_stats (0, &after);
+  if (after.free_cnt != before.free_cnt)
+    fail ("%zu pages free before, %zu after",
+          before.free_cnt, after.free_cnt);
+  if (after.largest_free != before.largest_free)
+    fail ("largest free block %zu pages before, %zu after",
+          before.largest_free, after.largest_free);
+  pass ();
+}
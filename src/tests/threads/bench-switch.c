@@ -0,0 +1,312 @@
+/* Context switch and wakeup microbenchmarks.
+
+   bench-yield measures thread_yield() round-robin among N
+   threads of equal priority, for N from 2 to 500, which is
+   dominated by schedule() and switch_threads().
+
+   bench-pingpong measures a semaphore handoff, sema_up() in one
+   thread followed by the sema_down() it unblocks returning in
+   another, with 0 to 500 lower-priority threads sitting in the
+   ready queue.
+
+   bench-lock measures handing a lock to a higher-priority
+   waiter, including the priority donation to the holder, with
+   the same range of ready-queue lengths.
+
+   Each prints one line per configuration of the form
+     bench NAME threads=N ops=N cycles=N cycles_per_op=N
+   or, for ready-queue benchmarks, ready=N instead of threads=N.
+   Cycles come from the time-stamp counter.  Configurations that
+   need more threads than memory allows are reported as skipped.
+   These tests always pass unless something goes wrong. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Thread counts and ready-queue lengths to measure. */
+static const int sizes[] = { 2, 10, 50, 100, 200, 500 };
+#define SIZE_CNT (sizeof sizes / sizeof *sizes)
+
+/* Total operations per configuration. */
+#define OPS 10000
+
+/* Shared state of a benchmark run. */
+static struct semaphore start, done;
+static int iterations;
+
+static void
+report (const char *name, const char *what, int n, long long ops,
+        uint64_t cycles)
+{
+  msg ("bench %s %s=%d ops=%lld cycles=%llu cycles_per_op=%llu",
+       name, what, n, ops, cycles, cycles / ops);
+}
+
+/* Yielder thread for bench-yield. */
+static void
+yielder (void *aux UNUSED)
+{
+  int i;
+
+  sema_down (&start);
+  for (i = 0; i < iterations; i++)
+    thread_yield ();
+  sema_up (&done);
+}
+
+/* Starts N threads running FUNC at PRIORITY, each of which
+   waits for START, then waits for them all to finish.  Returns
+   the number of cycles from releasing them to the last
+   finishing, or 0 if not all N threads could be created. */
+static uint64_t
+run_threads (int n, int priority, thread_func *func)
+{
+  uint64_t begin;
+  int created, i;
+
+  sema_init (&start, 0);
+  sema_init (&done, 0);
+  for (created = 0; created < n; created++)
+    if (thread_create ("bench", priority, func, NULL) == TID_ERROR)
+      {
+        /* Let the threads we did create finish at once. */
+        iterations = 0;
+        for (i = 0; i < created; i++)
+          sema_up (&start);
+        for (i = 0; i < created; i++)
+          sema_down (&done);
+        return 0;
+      }
+
+  begin = rdtsc ();
+  for (i = 0; i < n; i++)
+    sema_up (&start);
+  for (i = 0; i < n; i++)
+    sema_down (&done);
+  return rdtsc () - begin;
+}
+
+void
+test_bench_yield (void)
+{
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  for (i = 0; i < SIZE_CNT; i++)
+    {
+      int n = sizes[i];
+      uint64_t cycles;
+
+      iterations = OPS / n;
+      cycles = run_threads (n, PRI_DEFAULT, yielder);
+      if (cycles == 0)
+        msg ("bench yield threads=%d skipped", n);
+      else
+        report ("yield", "threads", n, (long long) n * (OPS / n), cycles);
+    }
+  pass ();
+}
+
+/* Filler threads that keep the ready queue populated while the
+   benchmark threads run above them. */
+static volatile bool fillers_stop;
+static struct semaphore fillers_done;
+
+static void
+filler (void *aux UNUSED)
+{
+  while (!fillers_stop)
+    thread_yield ();
+  sema_up (&fillers_done);
+}
+
+/* Starts N filler threads one priority level below the caller.
+   Returns the number actually created. */
+static int
+start_fillers (int n)
+{
+  int created;
+
+  fillers_stop = false;
+  sema_init (&fillers_done, 0);
+  for (created = 0; created < n; created++)
+    if (thread_create ("filler", PRI_DEFAULT - 1, filler, NULL) == TID_ERROR)
+      break;
+  return created;
+}
+
+/* Stops N filler threads and waits for them to exit. */
+static void
+stop_fillers (int n)
+{
+  int i;
+
+  fillers_stop = true;
+  for (i = 0; i < n; i++)
+    sema_down (&fillers_done);
+}
+
+/* Runs benchmark NAME, with ready queues of each length in
+   SIZES, by calling RUN, which returns the cycles taken by
+   iterations of OPS_PER_ITERATION operations. */
+static void
+bench_ready_queue (const char *name, uint64_t (*run) (void),
+                   int ops_per_iteration)
+{
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  for (i = 0; i < SIZE_CNT + 1; i++)
+    {
+      int n = i == 0 ? 0 : sizes[i - 1];
+      int fillers = start_fillers (n);
+      uint64_t cycles;
+
+      if (fillers < n)
+        {
+          stop_fillers (fillers);
+          msg ("bench %s ready=%d skipped", name, n);
+          continue;
+        }
+
+      iterations = OPS / ops_per_iteration;
+      cycles = run ();
+      stop_fillers (fillers);
+
+      report (name, "ready", n,
+              (long long) iterations * ops_per_iteration, cycles);
+    }
+  pass ();
+}
+
+/* bench-pingpong. */
+static struct semaphore ping, pong;
+
+static void
+pinger (void *aux UNUSED)
+{
+  int i;
+
+  sema_down (&start);
+  for (i = 0; i < iterations; i++)
+    {
+      sema_up (&ping);
+      sema_down (&pong);
+    }
+  sema_up (&done);
+}
+
+static void
+ponger (void *aux UNUSED)
+{
+  int i;
+
+  sema_down (&start);
+  for (i = 0; i < iterations; i++)
+    {
+      sema_down (&ping);
+      sema_up (&pong);
+    }
+  sema_up (&done);
+}
+
+static uint64_t
+run_pingpong (void)
+{
+  uint64_t begin;
+
+  sema_init (&start, 0);
+  sema_init (&done, 0);
+  sema_init (&ping, 0);
+  sema_init (&pong, 0);
+  thread_create ("ponger", PRI_DEFAULT + 1, ponger, NULL);
+  thread_create ("pinger", PRI_DEFAULT + 1, pinger, NULL);
+
+  begin = rdtsc ();
+  sema_up (&start);
+  sema_up (&start);
+  sema_down (&done);
+  sema_down (&done);
+  return rdtsc () - begin;
+}
+
+void
+test_bench_pingpong (void)
+{
+  /* Each round trip is two handoffs. */
+  bench_ready_queue ("pingpong", run_pingpong, 2);
+}
+
+/* bench-lock. */
+static struct lock handoff_lock;
+static struct semaphore go;
+
+/* Holder: takes the lock, wakes the waiter, which blocks on the
+   lock and donates its priority to us, then gives the lock
+   up. */
+static void
+lock_holder (void *aux UNUSED)
+{
+  int i;
+
+  sema_down (&start);
+  for (i = 0; i < iterations; i++)
+    {
+      lock_acquire (&handoff_lock);
+      sema_up (&go);
+      lock_release (&handoff_lock);
+    }
+  sema_up (&done);
+}
+
+/* Waiter: runs above the holder. */
+static void
+lock_waiter (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < iterations; i++)
+    {
+      sema_down (&go);
+      lock_acquire (&handoff_lock);
+      lock_release (&handoff_lock);
+    }
+  sema_up (&done);
+}
+
+static uint64_t
+run_lock (void)
+{
+  uint64_t begin;
+
+  sema_init (&start, 0);
+  sema_init (&done, 0);
+  sema_init (&go, 0);
+  lock_init (&handoff_lock);
+  thread_create ("waiter", PRI_DEFAULT + 2, lock_waiter, NULL);
+  thread_create ("holder", PRI_DEFAULT + 1, lock_holder, NULL);
+
+  begin = rdtsc ();
+  sema_up (&start);
+  sema_down (&done);
+  sema_down (&done);
+  return rdtsc () - begin;
+}
+
+void
+test_bench_lock (void)
+{
+  /* Each iteration switches from the holder to the waiter when
+     it is woken, back when it blocks on the lock, to the waiter
+     again when the lock is released, and back when it blocks on
+     GO. */
+  bench_ready_queue ("lock", run_lock, 4);
+}
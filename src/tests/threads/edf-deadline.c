@@ -0,0 +1,122 @@
+/* Checks that the earliest-deadline-first class meets every
+   deadline at 90% utilization, and that admission control turns
+   away more.
+
+   Starts four CPU-bound threads whose periods and budgets add up
+   to 90% of the CPU, and lets them run for 10 seconds.  Each
+   thread should miss no deadline and should receive at least its
+   reserved share of the ticks.  Meanwhile, asking to reserve
+   another 10% must fail. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 4
+
+/* Ticks that the threads spin for. */
+#define SPIN_TICKS (10 * TIMER_FREQ)
+
+struct thread_info
+  {
+    int period;                 /* EDF period, in ticks. */
+    int budget;                 /* EDF budget, in ticks. */
+    bool admitted;              /* Did thread_set_deadline() succeed? */
+    int64_t start_time;         /* When to start spinning. */
+    int tick_count;             /* Ticks seen while spinning. */
+    unsigned misses;            /* Deadlines missed. */
+    struct semaphore *started;  /* Upped when admitted or rejected. */
+    struct semaphore *done;     /* Upped when finished. */
+  };
+
+/* Utilizations 20%, 25%, 20%, and 25%. */
+static struct thread_info info[THREAD_CNT] =
+  {
+    { .period = 10, .budget = 2 },
+    { .period = 20, .budget = 5 },
+    { .period = 25, .budget = 5 },
+    { .period = 40, .budget = 10 },
+  };
+
+static thread_func edf_thread;
+
+void
+test_edf_deadline (void)
+{
+  struct semaphore started, done;
+  int64_t start_time;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&started, 0);
+  sema_init (&done, 0);
+  start_time = timer_ticks () + 10;
+  msg ("Starting %d EDF threads at 90%% utilization...", THREAD_CNT);
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct thread_info *ti = &info[i];
+      char name[16];
+
+      ti->start_time = start_time;
+      ti->started = &started;
+      ti->done = &done;
+      snprintf (name, sizeof name, "edf %d", i);
+      thread_create (name, PRI_DEFAULT, edf_thread, ti);
+    }
+
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&started);
+  if (thread_set_deadline (10, 1))
+    fail ("admitted a thread beyond 95%% utilization");
+  msg ("Reserving another 10%% was rejected.");
+
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct thread_info *ti = &info[i];
+      int reserved = SPIN_TICKS / ti->period * ti->budget;
+
+      if (!ti->admitted)
+        fail ("thread with period %d and budget %d was not admitted",
+              ti->period, ti->budget);
+      msg ("Period %d, budget %d: %u deadlines missed, "
+           "%d of %d reserved ticks seen.",
+           ti->period, ti->budget, ti->misses, ti->tick_count, reserved);
+      if (ti->misses != 0)
+        fail ("thread with period %d missed deadlines", ti->period);
+      if (ti->tick_count * 10 < reserved * 8)
+        fail ("thread with period %d ran for less than its reservation",
+              ti->period);
+    }
+  pass ();
+}
+
+static void
+edf_thread (void *ti_)
+{
+  struct thread_info *ti = ti_;
+  int64_t last_time = 0;
+
+  ti->admitted = thread_set_deadline (ti->period, ti->budget);
+  sema_up (ti->started);
+  while (timer_ticks () < ti->start_time)
+    continue;
+  while (timer_elapsed (ti->start_time) < SPIN_TICKS)
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ti->tick_count++;
+      last_time = cur_time;
+    }
+  ti->misses = thread_get_deadline_misses ();
+  thread_set_deadline (0, 0);
+  sema_up (ti->done);
+}
@@ -0,0 +1,72 @@
+/* Checks that malloc() of a multiple of PGSIZE bytes takes
+   exactly that many pages, and that realloc() resizes blocks in
+   place when it can, keeping their contents. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Returns the number of free pages in the kernel pool. */
+static size_t
+free_pages (void)
+{
+  struct palloc_stats stats;
+  palloc_get_stats (0, &stats);
+  return stats.free_cnt;
+}
+
+/* Fails unless the first SIZE bytes of BLOCK are all VALUE. */
+static void
+check_contents (const char *block, size_t size, char value)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    if (block[i] != value)
+      fail ("byte %zu changed from %d to %d", i, value, block[i]);
+}
+
+void
+test_malloc_realloc (void) 
+{
+  size_t before;
+  char *p, *q;
+
+  /* Exact-size big blocks.  Allocate one first so that the
+     table that records big blocks has memory of its own before
+     we start counting pages. */
+  free (malloc (PGSIZE));
+  before = free_pages ();
+  p = malloc (4 * PGSIZE);
+  if (p == NULL)
+    fail ("malloc failed");
+  msg ("4-page block took %zu pages.", before - free_pages ());
+  memset (p, 'a', 4 * PGSIZE);
+
+  /* Shrinking a big block frees its tail. */
+  q = realloc (p, PGSIZE);
+  msg ("Shrunk to 1 page %s, %zu pages still in use.",
+       q == p ? "in place" : "by moving", before - free_pages ());
+  check_contents (q, PGSIZE, 'a');
+
+  /* The pages just freed are free for growing it again. */
+  p = realloc (q, 3 * PGSIZE);
+  msg ("Grew to 3 pages %s, %zu pages in use.",
+       p == q ? "in place" : "by moving", before - free_pages ());
+  check_contents (p, PGSIZE, 'a');
+
+  /* Shrinking to descriptor size moves it. */
+  q = realloc (p, 100);
+  msg ("Shrunk to 100 bytes %s.", q == p ? "in place" : "by moving");
+  check_contents (q, 100, 'a');
+
+  /* Resizing within a descriptor's block size does not. */
+  p = realloc (q, 120);
+  msg ("Grew to 120 bytes %s.", p == q ? "in place" : "by moving");
+  check_contents (p, 100, 'a');
+
+  free (p);
+}
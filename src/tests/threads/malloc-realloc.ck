@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(malloc-realloc) begin
+(malloc-realloc) 4-page block took 4 pages.
+(malloc-realloc) Shrunk to 1 page in place, 1 pages still in use.
+(malloc-realloc) Grew to 3 pages in place, 3 pages in use.
+(malloc-realloc) Shrunk to 100 bytes by moving.
+(malloc-realloc) Grew to 120 bytes in place.
+(malloc-realloc) end
+EOF
+pass;
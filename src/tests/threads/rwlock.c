@@ -0,0 +1,107 @@
+/* Checks reader-writer locks.  The main thread holds read access
+   while a higher-priority reader gets in alongside it.  A writer
+   then has to wait for the readers to leave, and a later reader
+   of the same priority has to wait behind the writer.  Next, a
+   waiting writer donates its priority to the main thread while
+   the main thread holds write access.  Finally, the main thread
+   upgrades its read access once the other reader leaves, then
+   downgrades again, which lets a waiting reader in. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+static thread_func holder_thread_func;
+static thread_func waker_thread_func;
+
+static struct rwlock rw;
+static struct semaphore go;
+
+void
+test_rwlock (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rw_init (&rw);
+  sema_init (&go, 0);
+
+  /* Readers share. */
+  rw_read_acquire (&rw);
+  thread_create ("reader1", PRI_DEFAULT + 1, reader_thread_func, NULL);
+
+  /* Writers go ahead of readers of the same priority. */
+  thread_create ("writer1", PRI_DEFAULT + 1, writer_thread_func, NULL);
+  thread_create ("reader2", PRI_DEFAULT + 1, reader_thread_func, NULL);
+  msg ("main: releasing read access");
+  rw_read_release (&rw);
+
+  /* Waiting for a writer donates priority to it. */
+  rw_write_acquire (&rw);
+  thread_create ("writer2", PRI_DEFAULT + 2, writer_thread_func, NULL);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+  rw_write_release (&rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+
+  /* Upgrading waits for the other reader to leave. */
+  rw_read_acquire (&rw);
+  thread_create ("holder", PRI_DEFAULT + 1, holder_thread_func, NULL);
+  thread_create ("waker", PRI_DEFAULT - 1, waker_thread_func, NULL);
+  msg ("main: upgrading");
+  if (!rw_upgrade (&rw))
+    fail ("rw_upgrade failed with no other upgrade pending");
+  msg ("main: upgraded");
+
+  /* Downgrading lets waiting readers in. */
+  thread_create ("reader3", PRI_DEFAULT + 1, reader_thread_func, NULL);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+  msg ("main: downgrading");
+  rw_downgrade (&rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+  rw_read_release (&rw);
+}
+
+static void
+reader_thread_func (void *aux UNUSED) 
+{
+  rw_read_acquire (&rw);
+  msg ("%s: reading, readers=%u", thread_name (), rw.readers);
+  rw_read_release (&rw);
+}
+
+static void
+writer_thread_func (void *aux UNUSED) 
+{
+  rw_write_acquire (&rw);
+  msg ("%s: writing, readers=%u", thread_name (), rw.readers);
+  rw_write_release (&rw);
+}
+
+/* Reads until the waker lets it go. */
+static void
+holder_thread_func (void *aux UNUSED) 
+{
+  rw_read_acquire (&rw);
+  msg ("holder: reading, readers=%u", rw.readers);
+  sema_down (&go);
+  msg ("holder: leaving");
+  rw_read_release (&rw);
+}
+
+/* Runs only once the main thread blocks in rw_upgrade(). */
+static void
+waker_thread_func (void *aux UNUSED) 
+{
+  sema_up (&go);
+}
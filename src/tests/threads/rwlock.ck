@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock) begin
+(rwlock) reader1: reading, readers=2
+(rwlock) main: releasing read access
+(rwlock) writer1: writing, readers=0
+(rwlock) reader2: reading, readers=1
+(rwlock) This thread should have priority 33.  Actual priority: 33.
+(rwlock) writer2: writing, readers=0
+(rwlock) This thread should have priority 31.  Actual priority: 31.
+(rwlock) holder: reading, readers=2
+(rwlock) main: upgrading
+(rwlock) holder: leaving
+(rwlock) main: upgraded
+(rwlock) This thread should have priority 32.  Actual priority: 32.
+(rwlock) main: downgrading
+(rwlock) reader3: reading, readers=2
+(rwlock) This thread should have priority 31.  Actual priority: 31.
+(rwlock) end
+EOF
+pass;
@@ -0,0 +1,89 @@
+/* Checks kmem_cache_alloc() and kmem_cache_free() with objects
+   of an awkward size, enough of them to fill several slabs.
+   Every object must be distinct, must start out constructed,
+   and must keep its constructed state across a free and a
+   reallocation. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/slab.h"
+#include "threads/vaddr.h"
+
+/* An object a little over 512 bytes, like struct inode. */
+struct object
+  {
+    unsigned magic;
+    int users;
+    char data[512];
+  };
+
+#define OBJECT_MAGIC 0x0b1ec7ed
+
+/* Objects to allocate, enough for several slabs. */
+#define OBJ_CNT 40
+
+static int ctor_cnt;
+
+static void
+object_ctor (void *obj_)
+{
+  struct object *obj = obj_;
+  obj->magic = OBJECT_MAGIC;
+  obj->users = 0;
+  ctor_cnt++;
+}
+
+void
+test_slab_cache (void) 
+{
+  static struct object *objs[OBJ_CNT];
+  struct kmem_cache *cache;
+  int i, j;
+
+  cache = kmem_cache_create ("test", sizeof (struct object), object_ctor);
+
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      objs[i] = kmem_cache_alloc (cache);
+      if (objs[i] == NULL)
+        fail ("allocation %d failed", i);
+      if (objs[i]->magic != OBJECT_MAGIC || objs[i]->users != 0)
+        fail ("object %d not constructed", i);
+      if (pg_round_down (objs[i])
+          != pg_round_down ((char *) objs[i] + sizeof *objs[i] - 1))
+        fail ("object %d crosses a page boundary", i);
+      for (j = 0; j < i; j++)
+        if ((char *) objs[i] < (char *) objs[j] + sizeof *objs[j]
+            && (char *) objs[j] < (char *) objs[i] + sizeof *objs[i])
+          fail ("objects %d and %d overlap", j, i);
+      objs[i]->users++;
+      memset (objs[i]->data, i, sizeof objs[i]->data);
+    }
+  msg ("Allocated %d objects.", OBJ_CNT);
+  if (ctor_cnt < OBJ_CNT)
+    fail ("constructor ran %d times for %d objects", ctor_cnt, OBJ_CNT);
+
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      for (j = 0; j < (int) sizeof objs[i]->data; j++)
+        if (objs[i]->data[j] != (char) i)
+          fail ("object %d overwritten", i);
+
+      /* Return the object to its constructed state. */
+      objs[i]->users--;
+      kmem_cache_free (cache, objs[i]);
+    }
+  msg ("Freed %d objects.", OBJ_CNT);
+
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      objs[i] = kmem_cache_alloc (cache);
+      if (objs[i] == NULL || objs[i]->magic != OBJECT_MAGIC
+          || objs[i]->users != 0)
+        fail ("reallocated object %d not in constructed state", i);
+    }
+  for (i = 0; i < OBJ_CNT; i++)
+    kmem_cache_free (cache, objs[i]);
+  msg ("Reallocated and freed %d objects.", OBJ_CNT);
+}
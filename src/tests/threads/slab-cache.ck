@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(slab-cache) begin
+(slab-cache) Allocated 40 objects.
+(slab-cache) Freed 40 objects.
+(slab-cache) Reallocated and freed 40 objects.
+(slab-cache) end
+EOF
+pass;
@@ -0,0 +1,12 @@
+/* Checks that every processor that the machine reports was
+   started at boot.  Run with two processors, so that there is
+   one application processor to bring up. */
+
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+
+void
+test_smp_boot (void)
+{
+  msg ("%u of %u processors online.", cpu_online_cnt, cpu_cnt);
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(smp-boot) begin
+(smp-boot) 2 of 2 processors online.
+(smp-boot) end
+EOF
+pass;
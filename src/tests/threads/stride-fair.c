@@ -0,0 +1,128 @@
+/* Measures how closely the stride scheduler divides the CPU in
+   proportion to tickets.
+
+   Starts 100 CPU-bound threads holding 100, 200, 300, or 400
+   tickets, 25 threads of each, and lets them compete for 30
+   seconds.  Each thread should receive a share of the ticks
+   proportional to its tickets.  Reports, for each group, its
+   share of the ticks against the ideal, and the mean and worst
+   error of the individual threads.  Fails if any group's share
+   is more than 10% away from the ideal. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/sched.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 100
+#define GROUP_CNT 4
+
+struct thread_info
+  {
+    int64_t start_time;
+    int tick_count;
+    int tickets;
+  };
+
+static struct thread_info info[THREAD_CNT];
+
+static thread_func load_thread;
+
+void
+test_stride_fair (void)
+{
+  long long group_ticks[GROUP_CNT] = { 0 };
+  long long total_ticks = 0, total_tickets = 0;
+  long long error_sum = 0, error_max = 0;
+  int64_t start_time;
+  int i;
+
+  ASSERT (sched_class == &sched_stride_class);
+
+  /* Make sure we get to run when our sleep ends. */
+  thread_set_tickets (TICKETS_MAX);
+
+  start_time = timer_ticks ();
+  msg ("Starting %d threads...", THREAD_CNT);
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct thread_info *ti = &info[i];
+      char name[16];
+
+      ti->start_time = start_time;
+      ti->tick_count = 0;
+      ti->tickets = (i % GROUP_CNT + 1) * 100;
+      total_tickets += ti->tickets;
+
+      snprintf (name, sizeof name, "load %d", i);
+      thread_create (name, PRI_DEFAULT, load_thread, ti);
+    }
+  msg ("Starting threads took %"PRId64" ticks.", timer_elapsed (start_time));
+
+  msg ("Sleeping 40 seconds to let threads run, please wait...");
+  timer_sleep (40 * TIMER_FREQ);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      group_ticks[i % GROUP_CNT] += info[i].tick_count;
+      total_ticks += info[i].tick_count;
+    }
+  if (total_ticks == 0)
+    fail ("load threads did not run");
+
+  /* Errors are in tenths of a percent of the ideal share. */
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      long long ideal = total_ticks * info[i].tickets;
+      long long actual = info[i].tick_count * total_tickets;
+      long long error = (actual > ideal ? actual - ideal : ideal - actual)
+                        * 1000 / ideal;
+
+      error_sum += error;
+      if (error > error_max)
+        error_max = error;
+    }
+  msg ("Thread share error: mean %lld.%lld%%, worst %lld.%lld%%.",
+       error_sum / THREAD_CNT / 10, error_sum / THREAD_CNT % 10,
+       error_max / 10, error_max % 10);
+
+  for (i = 0; i < GROUP_CNT; i++)
+    {
+      long long tickets = (i + 1) * 100 * (THREAD_CNT / GROUP_CNT);
+      long long ideal = total_ticks * tickets;
+      long long actual = group_ticks[i] * total_tickets;
+      long long error = (actual > ideal ? actual - ideal : ideal - actual)
+                        * 1000 / ideal;
+
+      msg ("Threads with %d tickets received %lld of %lld ticks "
+           "(ideal %lld, error %lld.%lld%%).", (i + 1) * 100,
+           group_ticks[i], total_ticks, ideal / total_tickets,
+           error / 10, error % 10);
+      if (error > 100)
+        fail ("share of threads with %d tickets is off by more than 10%%",
+              (i + 1) * 100);
+    }
+  pass ();
+}
+
+static void
+load_thread (void *ti_)
+{
+  struct thread_info *ti = ti_;
+  int64_t sleep_time = 5 * TIMER_FREQ;
+  int64_t spin_time = sleep_time + 30 * TIMER_FREQ;
+  int64_t last_time = 0;
+
+  thread_set_tickets (ti->tickets);
+  timer_sleep (sleep_time - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time)
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ti->tick_count++;
+      last_time = cur_time;
+    }
+}
@@ -0,0 +1,148 @@
+/* Checks sema_down_timeout(), lock_acquire_timeout(), and
+   cond_wait_timeout(): each must give up once its time runs out,
+   and must report success when woken in time.  A timed-out lock
+   waiter must also take back the priority it donated, including
+   what passed on from the lock's holder to the writer of an
+   rwlock that the holder is waiting for. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func sema_upper;
+static thread_func lock_waiter;
+static thread_func chain_holder;
+static thread_func cond_signaler;
+
+struct cond_info
+  {
+    struct lock lock;
+    struct condition cond;
+  };
+
+struct chain_info
+  {
+    struct lock lock;
+    struct rwlock rw;
+  };
+
+void
+test_synch_timeout (void) 
+{
+  struct semaphore sema;
+  struct lock lock;
+  struct cond_info ci;
+  struct chain_info chain;
+  int64_t start;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  /* Semaphore. */
+  sema_init (&sema, 0);
+  start = timer_ticks ();
+  if (sema_down_timeout (&sema, 10))
+    fail ("sema_down_timeout succeeded on a zero semaphore");
+  if (timer_elapsed (start) < 10)
+    fail ("sema_down_timeout gave up early");
+  msg ("sema_down_timeout timed out.");
+
+  thread_create ("upper", PRI_DEFAULT - 1, sema_upper, &sema);
+  if (!sema_down_timeout (&sema, 1000))
+    fail ("sema_down_timeout timed out despite sema_up");
+  msg ("sema_down_timeout was signaled.");
+
+  /* Lock. */
+  lock_init (&lock);
+  lock_acquire (&lock);
+  thread_create ("waiter", PRI_DEFAULT + 1, lock_waiter, &lock);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+  timer_sleep (20);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+  lock_release (&lock);
+
+  /* Lock whose holder waits for an rwlock that we hold for
+     writing, so that the waiter's donation reaches us through
+     the holder. */
+  lock_init (&chain.lock);
+  rw_init (&chain.rw);
+  rw_write_acquire (&chain.rw);
+  thread_create ("holder", PRI_DEFAULT + 1, chain_holder, &chain);
+  thread_create ("waiter", PRI_DEFAULT + 3, lock_waiter, &chain.lock);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 3, thread_get_priority ());
+  timer_sleep (20);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+  rw_write_release (&chain.rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+
+  /* Condition variable. */
+  lock_init (&ci.lock);
+  cond_init (&ci.cond);
+  lock_acquire (&ci.lock);
+  if (cond_wait_timeout (&ci.cond, &ci.lock, 10))
+    fail ("cond_wait_timeout was signaled with no signaler");
+  msg ("cond_wait_timeout timed out, lock held: %s.",
+       lock_held_by_current_thread (&ci.lock) ? "yes" : "no");
+
+  thread_create ("signaler", PRI_DEFAULT - 1, cond_signaler, &ci);
+  if (!cond_wait_timeout (&ci.cond, &ci.lock, 1000))
+    fail ("cond_wait_timeout timed out despite cond_signal");
+  msg ("cond_wait_timeout was signaled, lock held: %s.",
+       lock_held_by_current_thread (&ci.lock) ? "yes" : "no");
+  lock_release (&ci.lock);
+}
+
+static void
+sema_upper (void *sema_) 
+{
+  struct semaphore *sema = sema_;
+
+  timer_sleep (5);
+  sema_up (sema);
+}
+
+static void
+lock_waiter (void *lock_) 
+{
+  struct lock *lock = lock_;
+
+  if (lock_acquire_timeout (lock, 10))
+    fail ("lock_acquire_timeout acquired a held lock");
+  msg ("waiter: lock_acquire_timeout timed out.");
+}
+
+/* Holds the lock while it waits for read access to the
+   rwlock. */
+static void
+chain_holder (void *chain_) 
+{
+  struct chain_info *chain = chain_;
+
+  lock_acquire (&chain->lock);
+  rw_read_acquire (&chain->rw);
+  msg ("holder: got read access.");
+  rw_read_release (&chain->rw);
+  lock_release (&chain->lock);
+}
+
+static void
+cond_signaler (void *ci_) 
+{
+  struct cond_info *ci = ci_;
+
+  timer_sleep (5);
+  lock_acquire (&ci->lock);
+  cond_signal (&ci->cond, &ci->lock);
+  lock_release (&ci->lock);
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(synch-timeout) begin
+(synch-timeout) sema_down_timeout timed out.
+(synch-timeout) sema_down_timeout was signaled.
+(synch-timeout) This thread should have priority 32.  Actual priority: 32.
+(synch-timeout) waiter: lock_acquire_timeout timed out.
+(synch-timeout) This thread should have priority 31.  Actual priority: 31.
+(synch-timeout) This thread should have priority 34.  Actual priority: 34.
+(synch-timeout) waiter: lock_acquire_timeout timed out.
+(synch-timeout) This thread should have priority 32.  Actual priority: 32.
+(synch-timeout) holder: got read access.
+(synch-timeout) This thread should have priority 31.  Actual priority: 31.
+(synch-timeout) cond_wait_timeout timed out, lock held: yes.
+(synch-timeout) cond_wait_timeout was signaled, lock held: yes.
+(synch-timeout) end
+EOF
+pass;
@@ -17,6 +17,7 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-idle", test_alarm_idle},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -25,6 +26,12 @@ static const struct test tests[] =
     {"priority-donate-sema", test_priority_donate_sema},
     {"priority-donate-lower", test_priority_donate_lower},
     {"priority-donate-chain", test_priority_donate_chain},
+    {"workqueue", test_workqueue},
+    {"synch-timeout", test_synch_timeout},
+    {"rwlock", test_rwlock},
+    {"slab-cache", test_slab_cache},
+    {"malloc-realloc", test_malloc_realloc},
+    {"smp-boot", test_smp_boot},
     {"priority-fifo", test_priority_fifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
@@ -38,6 +45,13 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"stride-fair", test_stride_fair},
+    {"edf-deadline", test_edf_deadline},
+    {"bench-yield", test_bench_yield},
+    {"bench-pingpong", test_bench_pingpong},
+    {"bench-lock", test_bench_lock},
+    {"bench-palloc", test_bench_palloc},
+    {"bench-malloc", test_bench_malloc},
   };
 
 static const char *test_name;
@@ -11,6 +11,7 @@ extern test_func test_alarm_simultaneous;
 extern test_func test_alarm_priority;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
+extern test_func test_alarm_idle;
 extern test_func test_priority_change;
 extern test_func test_priority_donate_one;
 extern test_func test_priority_donate_multiple;
@@ -19,6 +20,12 @@ extern test_func test_priority_donate_sema;
 extern test_func test_priority_donate_nest;
 extern test_func test_priority_donate_lower;
 extern test_func test_priority_donate_chain;
+extern test_func test_workqueue;
+extern test_func test_synch_timeout;
+extern test_func test_rwlock;
+extern test_func test_slab_cache;
+extern test_func test_malloc_realloc;
+extern test_func test_smp_boot;
 extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
@@ -32,6 +39,13 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_stride_fair;
+extern test_func test_edf_deadline;
+extern test_func test_bench_yield;
+extern test_func test_bench_pingpong;
+extern test_func test_bench_lock;
+extern test_func test_bench_palloc;
+extern test_func test_bench_malloc;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,86 @@
+/* Checks that workqueues run work in order, that queueing
+   pending work is a no-op, that delayed work waits for its delay
+   and can be cancelled, and that work on the high-priority queue
+   preempts its caller. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+#define WORK_CNT 3
+
+static int order[WORK_CNT];
+static int order_cnt;
+static int64_t ran_at;
+
+static work_func record_order;
+static work_func record_tick;
+
+void
+test_workqueue (void)
+{
+  struct work works[WORK_CNT];
+  struct work delayed;
+  int64_t start;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Queued work runs in order, once. */
+  for (i = 0; i < WORK_CNT; i++)
+    {
+      work_init (&works[i], record_order, (void *) i);
+      work_queue (&system_wq, &works[i]);
+    }
+  if (work_queue (&system_wq, &works[0]))
+    fail ("queueing pending work succeeded");
+  work_flush (&system_wq);
+  for (i = 0; i < order_cnt; i++)
+    msg ("Work %d ran.", order[i]);
+
+  /* Delayed work waits for its delay. */
+  ran_at = -1;
+  work_init (&delayed, record_tick, NULL);
+  start = timer_ticks ();
+  work_queue_delayed (&system_wq, &delayed, 10);
+  work_flush (&system_wq);
+  if (ran_at != -1)
+    fail ("delayed work ran early");
+  timer_sleep (20);
+  if (ran_at < start + 10)
+    fail ("delayed work ran %lld ticks early", start + 10 - ran_at);
+  msg ("Delayed work ran after its delay.");
+
+  /* Cancelled delayed work does not run. */
+  ran_at = -1;
+  work_queue_delayed (&system_wq, &delayed, 10);
+  if (!work_cancel (&delayed))
+    fail ("could not cancel delayed work");
+  timer_sleep (20);
+  if (ran_at != -1)
+    fail ("cancelled work ran");
+  msg ("Cancelled work did not run.");
+
+  /* High-priority work runs before work_queue() returns. */
+  ran_at = -1;
+  work_queue (&system_highpri_wq, &delayed);
+  if (ran_at == -1)
+    fail ("high-priority work did not preempt");
+  msg ("High-priority work preempted its caller.");
+}
+
+static void
+record_order (struct work *w)
+{
+  order[order_cnt++] = (int) w->aux;
+}
+
+static void
+record_tick (struct work *w UNUSED)
+{
+  ran_at = timer_ticks ();
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) Work 0 ran.
+(workqueue) Work 1 ran.
+(workqueue) Work 2 ran.
+(workqueue) Delayed work ran after its delay.
+(workqueue) Cancelled work did not run.
+(workqueue) High-priority work preempted its caller.
+(workqueue) end
+EOF
+pass;
@@ -0,0 +1,13 @@
+/* Child process run by fpu-preempt.
+   Holds its own value in the FPU and exits with the number of
+   rounds in which it came back wrong. */
+
+#include "tests/lib.h"
+#include "tests/userprog/fpu.h"
+
+int
+main (void) 
+{
+  test_name = "child-fpu";
+  return fpu_hold_rounds (FPU_CHILD_VALUE);
+}
@@ -0,0 +1,18 @@
+/* Holds a value in the x87 registers across preemption while a
+   child process does the same with a different value, and
+   checks that neither sees the other's. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/userprog/fpu.h"
+
+void
+test_main (void) 
+{
+  pid_t child;
+
+  CHECK ((child = exec ("child-fpu")) != -1, "exec child-fpu");
+  CHECK (fpu_hold_rounds (FPU_PARENT_VALUE) == 0, "parent kept its value");
+  CHECK (wait (child) == 0, "child kept its value");
+}
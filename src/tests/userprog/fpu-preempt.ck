@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF', <<'EOF']);
+(fpu-preempt) begin
+(fpu-preempt) exec child-fpu
+(fpu-preempt) parent kept its value
+child-fpu: exit(0)
+(fpu-preempt) child kept its value
+(fpu-preempt) end
+fpu-preempt: exit(0)
+EOF
+(fpu-preempt) begin
+(fpu-preempt) exec child-fpu
+child-fpu: exit(0)
+(fpu-preempt) parent kept its value
+(fpu-preempt) child kept its value
+(fpu-preempt) end
+fpu-preempt: exit(0)
+EOF
+pass;
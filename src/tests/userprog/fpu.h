@@ -0,0 +1,44 @@
+#ifndef TESTS_USERPROG_FPU_H
+#define TESTS_USERPROG_FPU_H
+
+/* Values held by fpu-preempt and child-fpu. */
+#define FPU_PARENT_VALUE 1234567
+#define FPU_CHILD_VALUE 7654321
+
+/* Number of rounds, and iterations of the busy loop per round.
+   Each round should span several time slices. */
+#define FPU_ROUNDS 8
+#define FPU_SPINS 20000000
+
+/* Loads VALUE onto the x87 stack, spins for SPINS iterations
+   without touching the FPU, and returns what comes back off the
+   stack.  User programs are compiled with -msoft-float, so the
+   only FPU instructions are these. */
+static inline int
+fpu_hold (int value, unsigned spins)
+{
+  int result;
+
+  asm volatile ("fildl %2\n"
+                "1: loop 1b\n"
+                "fistpl %0"
+                : "=m" (result), "+c" (spins)
+                : "m" (value));
+  return result;
+}
+
+/* Holds VALUE across FPU_ROUNDS rounds and returns the number in
+   which it came back wrong. */
+static inline int
+fpu_hold_rounds (int value)
+{
+  int errors = 0;
+  int i;
+
+  for (i = 0; i < FPU_ROUNDS; i++)
+    if (fpu_hold (value, FPU_SPINS) != value)
+      errors++;
+  return errors;
+}
+
+#endif /* tests/userprog/fpu.h */
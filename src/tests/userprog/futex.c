@@ -0,0 +1,19 @@
+/* Exercises the futex calls that do not need a second thread:
+   waiting on a word that no longer holds the expected value must
+   return at once, and waking a word nobody waits on must wake
+   no one. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int word = 1;
+
+void
+test_main (void) 
+{
+  CHECK (futex_wait (&word, 0) == -1, "wait with stale value");
+  CHECK (futex_wake (&word, 1) == 0, "wake with no waiters");
+  word = 0;
+  CHECK (futex_wake (&word, 10) == 0, "wake again");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex) begin
+(futex) wait with stale value
+(futex) wake with no waiters
+(futex) wake again
+(futex) end
+futex: exit(0)
+EOF
+pass;
@@ -0,0 +1,15 @@
+/* Passes a pointer into the read-only code segment to the
+   intrstat system call.  The kernel must not write the
+   statistics there; the process must be terminated with -1
+   exit code instead. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  intrstat (0x30, (struct intrstat *) test_main);
+  fail ("should have exited with -1");
+}
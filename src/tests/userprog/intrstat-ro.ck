@@ -0,0 +1,9 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(intrstat-ro) begin
+intrstat-ro: exit(-1)
+EOF
+pass;
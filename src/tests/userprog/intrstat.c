@@ -0,0 +1,27 @@
+/* Reads the interrupt statistics and checks that they account
+   for the timer and for this process's own system calls. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct intrstat st;
+
+  CHECK (intrstat (0x30, &st), "intrstat syscall vector");
+  if (strcmp (st.name, "syscall"))
+    fail ("vector 0x30 is named \"%s\", not \"syscall\"", st.name);
+  if (st.count == 0)
+    fail ("no system calls counted");
+  if (st.max_cycles == 0 || st.total_cycles < st.max_cycles)
+    fail ("system call cycles are inconsistent");
+
+  CHECK (intrstat (0x20, &st), "intrstat timer vector");
+  if (st.count == 0)
+    fail ("no timer interrupts counted");
+
+  CHECK (!intrstat (256, &st), "intrstat out of range");
+}
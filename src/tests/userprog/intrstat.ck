@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(intrstat) begin
+(intrstat) intrstat syscall vector
+(intrstat) intrstat timer vector
+(intrstat) intrstat out of range
+(intrstat) end
+intrstat: exit(0)
+EOF
+pass;
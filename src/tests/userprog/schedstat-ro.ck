@@ -0,0 +1,9 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(schedstat-ro) begin
+schedstat-ro: exit(-1)
+EOF
+pass;
@@ -0,0 +1,24 @@
+/* Reads the scheduler statistics and checks that they account
+   for this process having been created and run. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct schedstat st;
+  unsigned wakeups = 0;
+  int i;
+
+  CHECK (schedstat (&st), "schedstat");
+  if (st.run_cycles == 0)
+    fail ("no running time accounted to this process");
+
+  /* Creating this process woke it up at least once. */
+  for (i = 0; i < SCHEDSTAT_BUCKETS; i++)
+    wakeups += st.latency_hist[i];
+  if (wakeups == 0)
+    fail ("wakeup latency histogram is empty");
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(schedstat) begin
+(schedstat) schedstat
+(schedstat) end
+schedstat: exit(0)
+EOF
+pass;
@@ -0,0 +1,19 @@
+/* Moves this process into EDF scheduling and back out, and
+   checks that invalid and overloading reservations are
+   refused. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  CHECK (!set_deadline (10, 0), "zero budget rejected");
+  CHECK (!set_deadline (10, 11), "budget over period rejected");
+  CHECK (!set_deadline (-1, 1), "negative period rejected");
+  CHECK (set_deadline (10, 5), "50%% reserved");
+  CHECK (!set_deadline (10, 10), "100%% rejected");
+  CHECK (set_deadline (20, 5), "changed to 25%%");
+  CHECK (set_deadline (0, 0), "left EDF");
+}
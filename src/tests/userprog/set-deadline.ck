@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(set-deadline) begin
+(set-deadline) zero budget rejected
+(set-deadline) budget over period rejected
+(set-deadline) negative period rejected
+(set-deadline) 50% reserved
+(set-deadline) 100% rejected
+(set-deadline) changed to 25%
+(set-deadline) left EDF
+(set-deadline) end
+set-deadline: exit(0)
+EOF
+pass;
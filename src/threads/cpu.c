@@ -0,0 +1,360 @@
+#include "threads/cpu.h"
+#include <debug.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/init.h"
+#include "threads/loader.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Processors found at boot.  cpus[0] is the one we run on. */
+struct cpu cpus[CPU_MAX];
+
+/* Number of processors in cpus[].  At least 1. */
+unsigned cpu_cnt = 1;
+
+/* Number of processors running, counting the bootstrap
+   processor.  Set by cpu_start_aps(). */
+unsigned cpu_online_cnt = 1;
+
+/* Physical address of every processor's local APIC, which the
+   kernel also maps at the same virtual address.  See [IA32-v3a]
+   chapter 10 "Advanced Programmable Interrupt Controller". */
+static uint32_t lapic_paddr = 0xfee00000;
+static volatile uint32_t *lapic;
+
+/* Local APIC registers, as byte offsets. */
+#define LAPIC_ID 0x020          /* ID, in bits 24...31. */
+#define LAPIC_SVR 0x0f0         /* Spurious interrupt vector. */
+#define LAPIC_ICR_LO 0x300      /* Interrupt command, low half. */
+#define LAPIC_ICR_HI 0x310      /* Interrupt command, high half. */
+#define LAPIC_LINT0 0x350       /* Local vector table, LINT0 pin. */
+#define LAPIC_LINT1 0x360       /* Local vector table, LINT1 pin. */
+
+#define SVR_ENABLE 0x100        /* APIC software enable. */
+#define SPURIOUS_VECTOR 0xff    /* Vector for spurious interrupts. */
+
+#define LVT_NMI 0x400           /* Delivery mode: NMI. */
+#define LVT_EXTINT 0x700        /* Delivery mode: from the 8259A PIC. */
+
+#define ICR_INIT 0x500          /* Delivery mode: INIT. */
+#define ICR_STARTUP 0x600       /* Delivery mode: STARTUP. */
+#define ICR_PENDING 0x1000      /* Delivery status: not yet accepted. */
+#define ICR_ASSERT 0x4000       /* Level: assert. */
+#define ICR_LEVEL 0x8000        /* Trigger mode: level. */
+
+/* Physical address of the page that application processors start
+   in.  It must be below 1 MB and page-aligned, and it must not
+   overlap the loader's command line at 0x7c00 or the temporary
+   page directory at 0xf000. */
+#define AP_TRAMPOLINE 0x8000
+
+/* Application processor startup code, in start.S. */
+extern const char ap_trampoline[], ap_trampoline_end[];
+
+/* Stack and processor for the application processor being
+   started.  start.S switches to ap_boot_stack. */
+void *ap_boot_stack;
+static struct cpu *volatile ap_boot_cpu;
+
+void ap_main (void) NO_RETURN;
+
+/* MP floating pointer structure.  See the Intel MultiProcessor
+   Specification, version 1.4, section 4.1. */
+struct mp_float
+  {
+    char signature[4];          /* "_MP_". */
+    uint32_t config_paddr;      /* Physical address of config table. */
+    uint8_t length;             /* In 16-byte units, always 1. */
+    uint8_t spec_rev;           /* Specification revision. */
+    uint8_t checksum;           /* Makes all bytes sum to 0. */
+    uint8_t features[5];        /* features[0] != 0: default config. */
+  } __attribute__ ((packed));
+
+/* MP configuration table header.  Section 4.2. */
+struct mp_config
+  {
+    char signature[4];          /* "PCMP". */
+    uint16_t length;            /* Header plus base entries, in bytes. */
+    uint8_t spec_rev;           /* Specification revision. */
+    uint8_t checksum;           /* Makes all bytes sum to 0. */
+    char oem_id[8];
+    char product_id[12];
+    uint32_t oem_table_paddr;
+    uint16_t oem_table_size;
+    uint16_t entry_cnt;         /* Number of base entries. */
+    uint32_t lapic_paddr;       /* Local APIC address. */
+    uint16_t ext_length;
+    uint8_t ext_checksum;
+    uint8_t reserved;
+  } __attribute__ ((packed));
+
+/* MP configuration table processor entry.  Section 4.3.1.
+   Entries of every other type are 8 bytes long. */
+#define MP_PROCESSOR 0
+struct mp_processor
+  {
+    uint8_t type;               /* MP_PROCESSOR. */
+    uint8_t apic_id;            /* Local APIC ID. */
+    uint8_t apic_version;
+    uint8_t flags;              /* MP_CPU_* flags. */
+    uint32_t signature;
+    uint32_t features;
+    uint32_t reserved[2];
+  } __attribute__ ((packed));
+
+#define MP_CPU_ENABLED 0x01     /* Usable processor. */
+#define MP_CPU_BSP 0x02         /* Bootstrap processor. */
+
+/* Returns a kernel virtual address for SIZE bytes of physical
+   memory at PADDR, or a null pointer if they are not all mapped
+   in the kernel's RAM mapping. */
+static void *
+phys_range (uint32_t paddr, size_t size)
+{
+  uint32_t ram_size = init_ram_pages * PGSIZE;
+
+  if (paddr >= ram_size || size > ram_size - paddr)
+    return NULL;
+  return ptov (paddr);
+}
+
+/* Returns true if the SIZE bytes at P sum to 0, modulo 256. */
+static bool
+checksum_ok (const void *p, size_t size)
+{
+  const uint8_t *bytes = p;
+  uint8_t sum = 0;
+
+  while (size-- > 0)
+    sum += *bytes++;
+  return sum == 0;
+}
+
+/* Searches SIZE bytes of physical memory at PADDR for an MP
+   floating pointer structure, which is aligned on a 16-byte
+   boundary, and returns it, or a null pointer if there is
+   none. */
+static struct mp_float *
+mp_search (uint32_t paddr, size_t size)
+{
+  uint8_t *p = phys_range (paddr, size);
+  uint8_t *end = p + size;
+
+  if (p == NULL)
+    return NULL;
+  for (; p + sizeof (struct mp_float) <= end; p += 16)
+    if (!memcmp (p, "_MP_", 4) && checksum_ok (p, sizeof (struct mp_float)))
+      return (struct mp_float *) p;
+  return NULL;
+}
+
+/* Finds the MP floating pointer structure in one of the places
+   that section 4 of the specification allows: the first
+   kilobyte of the extended BIOS data area, the last kilobyte of
+   base memory, or the BIOS ROM. */
+static struct mp_float *
+mp_find (void)
+{
+  uint16_t ebda_segment = *(uint16_t *) ptov (0x40e);
+  uint16_t base_kb = *(uint16_t *) ptov (0x413);
+  struct mp_float *mpf = NULL;
+
+  if (ebda_segment != 0)
+    mpf = mp_search ((uint32_t) ebda_segment << 4, 1024);
+  if (mpf == NULL && base_kb != 0)
+    mpf = mp_search (((uint32_t) base_kb - 1) * 1024, 1024);
+  if (mpf == NULL)
+    mpf = mp_search (0xf0000, 0x10000);
+  return mpf;
+}
+
+/* Adds the processor with local APIC APIC_ID to cpus[], as the
+   bootstrap processor cpus[0] if IS_BSP. */
+static void
+add_cpu (uint8_t apic_id, bool is_bsp)
+{
+  struct cpu *c;
+
+  if (is_bsp)
+    c = &cpus[0];
+  else if (cpu_cnt < CPU_MAX)
+    c = &cpus[cpu_cnt++];
+  else
+    return;
+  c->id = c - cpus;
+  c->apic_id = apic_id;
+}
+
+/* Counts the processors described by the firmware's MP tables.
+   Without them, we assume a uniprocessor.  Must be called after
+   paging_init(), so that all of low memory is mapped. */
+void
+cpu_init (void)
+{
+  struct mp_float *mpf = mp_find ();
+  struct mp_config *mpc;
+  uint8_t *entry, *end;
+  unsigned i;
+
+  if (mpf == NULL)
+    return;
+  if (mpf->features[0] != 0)
+    {
+      /* One of the default configurations, all of which have two
+         processors, with APIC IDs 0 and 1. */
+      add_cpu (0, true);
+      add_cpu (1, false);
+      goto done;
+    }
+
+  mpc = phys_range (mpf->config_paddr, sizeof *mpc);
+  if (mpc == NULL || memcmp (mpc->signature, "PCMP", 4)
+      || phys_range (mpf->config_paddr, mpc->length) == NULL
+      || !checksum_ok (mpc, mpc->length))
+    return;
+
+  lapic_paddr = mpc->lapic_paddr;
+  entry = (uint8_t *) (mpc + 1);
+  end = (uint8_t *) mpc + mpc->length;
+  for (i = 0; i < mpc->entry_cnt && entry < end; i++)
+    if (*entry == MP_PROCESSOR)
+      {
+        struct mp_processor *proc = (struct mp_processor *) entry;
+        if (proc->flags & MP_CPU_ENABLED)
+          add_cpu (proc->apic_id, proc->flags & MP_CPU_BSP);
+        entry += sizeof *proc;
+      }
+    else
+      entry += 8;
+
+ done:
+  if (cpu_cnt > 1)
+    printf ("Found %u CPUs.\n", cpu_cnt);
+}
+
+/* Returns the local APIC register at byte offset REG. */
+static uint32_t
+lapic_read (unsigned reg)
+{
+  return lapic[reg / 4];
+}
+
+/* Sets the local APIC register at byte offset REG to VALUE. */
+static void
+lapic_write (unsigned reg, uint32_t value)
+{
+  lapic[reg / 4] = value;
+}
+
+/* Maps the local APIC's registers into the kernel page table, at
+   a virtual address equal to their physical address, with
+   caching disabled.  User page directories copy the kernel's
+   page directory entries when they are created, so this must
+   happen before the first one is. */
+static void
+lapic_map (void)
+{
+  uint32_t *pd = init_page_dir;
+  uint32_t *pt;
+  void *va = (void *) lapic_paddr;
+
+  ASSERT (is_kernel_vaddr (va));
+  ASSERT (pg_ofs (va) == 0);
+
+  if (pd[pd_no (va)] == 0)
+    pd[pd_no (va)] = pde_create (palloc_get_page (PAL_ASSERT | PAL_ZERO));
+  pt = pde_get_pt (pd[pd_no (va)]);
+  pt[pt_no (va)] = lapic_paddr | PTE_P | PTE_W | PTE_PCD | PTE_PWT;
+  asm volatile ("movl %0, %%cr3" : : "r" (vtop (init_page_dir)) : "memory");
+  lapic = va;
+}
+
+/* Sends an interrupt command to the processor whose local APIC
+   has ID APIC_ID, and waits for its APIC to accept it. */
+static void
+lapic_send (uint8_t apic_id, uint32_t command)
+{
+  lapic_write (LAPIC_ICR_HI, (uint32_t) apic_id << 24);
+  lapic_write (LAPIC_ICR_LO, command);
+  while (lapic_read (LAPIC_ICR_LO) & ICR_PENDING)
+    continue;
+}
+
+/* Starts processor C, following the universal startup algorithm
+   of the Intel MultiProcessor Specification, appendix B.4, and
+   waits up to 100 ms for it to reach ap_main().  Returns true if
+   it does. */
+static bool
+start_ap (struct cpu *c)
+{
+  int i;
+
+  ap_boot_stack = (uint8_t *) palloc_get_page (PAL_ASSERT) + PGSIZE;
+  ap_boot_cpu = c;
+
+  lapic_send (c->apic_id, ICR_INIT | ICR_LEVEL | ICR_ASSERT);
+  lapic_send (c->apic_id, ICR_INIT | ICR_LEVEL);
+  timer_mdelay (10);
+  for (i = 0; i < 2; i++)
+    {
+      lapic_send (c->apic_id, ICR_STARTUP | (AP_TRAMPOLINE >> PGBITS));
+      timer_udelay (200);
+    }
+
+  for (i = 0; i < 100 && !c->started; i++)
+    timer_mdelay (1);
+  return c->started;
+}
+
+/* Starts each application processor that cpu_init() found and
+   leaves it halted, with interrupts disabled, in ap_main().
+   Must be called after timer_calibrate(), and before the first
+   user process is created. */
+void
+cpu_start_aps (void)
+{
+  unsigned i;
+
+  if (cpu_cnt == 1)
+    return;
+
+  lapic_map ();
+  lapic_write (LAPIC_LINT0, LVT_EXTINT);
+  lapic_write (LAPIC_LINT1, LVT_NMI);
+  lapic_write (LAPIC_SVR, SVR_ENABLE | SPURIOUS_VECTOR);
+  cpus[0].apic_id = lapic_read (LAPIC_ID) >> 24;
+
+  memcpy (ptov (AP_TRAMPOLINE), ap_trampoline,
+          ap_trampoline_end - ap_trampoline);
+  for (i = 1; i < cpu_cnt; i++)
+    if (!start_ap (&cpus[i]))
+      printf ("CPU %u (APIC ID %u) did not start.\n",
+              i, cpus[i].apic_id);
+  printf ("%u of %u CPUs online.\n", cpu_online_cnt, cpu_cnt);
+}
+
+/* Entry point for application processors, called by start.S on
+   the stack that start_ap() allocated.  There is no thread here,
+   so nothing that calls thread_current() may be used, including
+   locks and printf(). */
+void
+ap_main (void)
+{
+  struct cpu *c = ap_boot_cpu;
+
+  asm volatile ("movl %0, %%cr3" : : "r" (vtop (init_page_dir)) : "memory");
+  lapic_write (LAPIC_SVR, SVR_ENABLE | SPURIOUS_VECTOR);
+
+  cpu_online_cnt++;
+  barrier ();
+  c->started = true;
+
+  for (;;)
+    asm volatile ("cli; hlt" : : : "memory");
+}
@@ -0,0 +1,56 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
+
+/* Most processors that cpu_init() will record. */
+#define CPU_MAX 16
+
+/* Per-CPU state.
+
+   Threads run only on the bootstrap processor, cpus[0].
+   cpu_init() finds the application processors that the firmware
+   reports, and cpu_start_aps() starts each of them and parks it
+   with interrupts off, so that they take no part in scheduling
+   yet.  State that each processor needs its own copy of once
+   they do lives here rather than in globals, so that
+   cpu_current() is the one place to change. */
+struct cpu
+  {
+    unsigned id;                /* Index in cpus[]. */
+    uint8_t apic_id;            /* Local APIC ID. */
+    bool started;               /* Has reached ap_main()?  (APs only.) */
+    struct thread *idle_thread; /* Runs when nothing else is ready. */
+    long long idle_ticks;       /* # of timer ticks spent idle. */
+    long long kernel_ticks;     /* # of timer ticks in kernel threads. */
+    long long user_ticks;       /* # of timer ticks in user programs. */
+  };
+
+extern struct cpu cpus[CPU_MAX];
+extern unsigned cpu_cnt;
+extern unsigned cpu_online_cnt;
+
+void cpu_init (void);
+void cpu_start_aps (void);
+
+/* Returns the processor we are running on. */
+static inline struct cpu *
+cpu_current (void)
+{
+  return &cpus[0];
+}
+
+/* Returns the processor's time-stamp counter, which counts CPU
+   clock cycles since reset.  See [IA32-v2b] "RDTSC". */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+#endif /* threads/cpu.h */
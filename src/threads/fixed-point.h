@@ -0,0 +1,60 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* Signed 17.14 fixed-point arithmetic, as used by the 4.4BSD
+   scheduler for load_avg and recent_cpu.  A fixed-point number
+   is stored in an int whose low FP_FRAC_BITS bits hold the
+   fraction.  See the "4.4BSD Scheduler" appendix of the Pintos
+   reference guide for details.
+
+   N is an integer; X and Y are fixed-point numbers. */
+typedef int fixed_t;
+
+#define FP_FRAC_BITS 14                 /* Bits after the point. */
+#define FP_F (1 << FP_FRAC_BITS)        /* Fixed-point 1. */
+
+/* Converts N to fixed point. */
+static inline fixed_t
+fp_from_int (int n)
+{
+  return n * FP_F;
+}
+
+/* Converts X to an integer, rounding toward zero. */
+static inline int
+fp_to_int (fixed_t x)
+{
+  return x / FP_F;
+}
+
+/* Converts X to an integer, rounding to nearest. */
+static inline int
+fp_round (fixed_t x)
+{
+  return x >= 0 ? (x + FP_F / 2) / FP_F : (x - FP_F / 2) / FP_F;
+}
+
+/* Returns X + N. */
+static inline fixed_t
+fp_add_int (fixed_t x, int n)
+{
+  return x + n * FP_F;
+}
+
+/* Returns X * Y. */
+static inline fixed_t
+fp_mul (fixed_t x, fixed_t y)
+{
+  return ((int64_t) x) * y / FP_F;
+}
+
+/* Returns X / Y. */
+static inline fixed_t
+fp_div (fixed_t x, fixed_t y)
+{
+  return ((int64_t) x) * FP_F / y;
+}
+
+#endif /* threads/fixed-point.h */
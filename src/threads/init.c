@@ -15,16 +15,20 @@
 #include "devices/timer.h"
 #include "devices/vga.h"
 #include "devices/rtc.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/sched.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
+#include "userprog/fpu.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
@@ -98,6 +102,7 @@ main (void)
   palloc_init (user_page_limit);
   malloc_init ();
   paging_init ();
+  cpu_init ();
 
   /* Segmentation. */
 #ifdef USERPROG
@@ -112,13 +117,17 @@ main (void)
   input_init ();
 #ifdef USERPROG
   exception_init ();
+  fpu_init ();
+  process_init ();
   syscall_init ();
 #endif
 
   /* Start thread scheduler and enable interrupts. */
   thread_start ();
+  workqueue_init ();
   serial_init_queue ();
   timer_calibrate ();
+  cpu_start_aps ();
 
 #ifdef FILESYS
   /* Initialize file system. */
@@ -255,7 +264,15 @@ parse_options (char **argv)
       else if (!strcmp (name, "-rs"))
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
-        thread_mlfqs = true;
+        sched_select ("mlfqs");
+      else if (!strcmp (name, "-sched"))
+        {
+          if (value == NULL || !sched_select (value))
+            PANIC ("unknown scheduler `%s' (use -h for help)",
+                   value != NULL ? value : "");
+        }
+      else if (!strcmp (name, "-tickless"))
+        timer_tickless = true;
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
@@ -379,6 +396,9 @@ usage (void)
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -sched=NAME        Use scheduler NAME: priority (default),\n"
+          "                     mlfqs, or stride.\n"
+          "  -tickless          Stop the periodic timer tick while idle.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
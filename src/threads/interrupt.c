@@ -3,6 +3,8 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
@@ -37,6 +39,16 @@ static const char *intr_names[INTR_CNT];
    unexpected interrupt is one that has no registered handler. */
 static unsigned int unexpected_cnt[INTR_CNT];
 
+/* Invocation counts and handler timing for each vector. */
+struct vector_stats
+  {
+    uint64_t count;             /* Number of invocations. */
+    uint64_t total_cycles;      /* Cycles spent in handler. */
+    uint64_t max_cycles;        /* Longest single invocation. */
+    unsigned yields;            /* Yields requested on return. */
+  };
+static struct vector_stats vector_stats[INTR_CNT];
+
 /* External interrupts are those generated by devices outside the
    CPU, such as the timer.  External interrupts run with
    interrupts turned off, so they never nest, nor are they ever
@@ -47,6 +59,39 @@ static unsigned int unexpected_cnt[INTR_CNT];
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+#ifdef INTR_TRACE
+/* Interrupts-off latency tracing.  Each transition from
+   interrupts on to off, and back, made through intr_disable(),
+   intr_enable(), or intr_set_level() is timestamped with the
+   time-stamp counter.  For each call site that turned interrupts
+   off, we keep the longest window it opened, along with the site
+   that closed it, which for a window spanning a thread switch is
+   in another thread.
+
+   Interrupts are off whenever this state changes, so it needs no
+   other synchronization. */
+#define TRACE_SITE_CNT 16
+
+struct trace_site
+  {
+    void *disable_eip;          /* Caller that turned interrupts off. */
+    void *enable_eip;           /* Caller that ended longest window. */
+    uint64_t max_cycles;        /* Longest window from this site. */
+    uint64_t total_cycles;      /* Sum of all windows from this site. */
+    unsigned count;             /* Number of windows from this site. */
+  };
+
+static struct trace_site trace_sites[TRACE_SITE_CNT];
+static uint64_t trace_start;    /* TSC when interrupts went off, or 0. */
+static void *trace_disable_eip; /* Caller that turned them off. */
+static unsigned trace_dropped;  /* Windows not recorded: table full. */
+
+static void trace_window (void *enable_eip);
+#endif
+
+static enum intr_level do_enable (void *caller);
+static enum intr_level do_disable (void *caller);
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
@@ -80,16 +125,37 @@ intr_get_level (void)
 enum intr_level
 intr_set_level (enum intr_level level) 
 {
-  return level == INTR_ON ? intr_enable () : intr_disable ();
+  void *caller = __builtin_return_address (0);
+  return level == INTR_ON ? do_enable (caller) : do_disable (caller);
 }
 
 /* Enables interrupts and returns the previous interrupt status. */
 enum intr_level
 intr_enable (void) 
+{
+  return do_enable (__builtin_return_address (0));
+}
+
+/* Disables interrupts and returns the previous interrupt status. */
+enum intr_level
+intr_disable (void) 
+{
+  return do_disable (__builtin_return_address (0));
+}
+
+/* Enables interrupts on behalf of CALLER and returns the
+   previous interrupt status. */
+static enum intr_level
+do_enable (void *caller UNUSED) 
 {
   enum intr_level old_level = intr_get_level ();
   ASSERT (!intr_context ());
 
+#ifdef INTR_TRACE
+  if (old_level == INTR_OFF)
+    trace_window (caller);
+#endif
+
   /* Enable interrupts by setting the interrupt flag.
 
      See [IA32-v2b] "STI" and [IA32-v3a] 5.8.1 "Masking Maskable
@@ -99,9 +165,10 @@ intr_enable (void)
   return old_level;
 }
 
-/* Disables interrupts and returns the previous interrupt status. */
-enum intr_level
-intr_disable (void) 
+/* Disables interrupts on behalf of CALLER and returns the
+   previous interrupt status. */
+static enum intr_level
+do_disable (void *caller UNUSED) 
 {
   enum intr_level old_level = intr_get_level ();
 
@@ -110,8 +177,106 @@ intr_disable (void)
      Hardware Interrupts". */
   asm volatile ("cli" : : : "memory");
 
+#ifdef INTR_TRACE
+  if (old_level == INTR_ON)
+    {
+      trace_start = rdtsc ();
+      trace_disable_eip = caller;
+    }
+#endif
+
   return old_level;
 }
+
+#ifdef INTR_TRACE
+/* Ends the interrupts-off window begun at trace_start, which
+   ENABLE_EIP is about to close, and records it against the site
+   that opened it.  If that site has no slot and the table is
+   full, the shortest recorded site gives way to it. */
+static void
+trace_window (void *enable_eip)
+{
+  struct trace_site *s, *min = NULL;
+  uint64_t cycles;
+
+  if (trace_start == 0)
+    return;
+  cycles = rdtsc () - trace_start;
+  trace_start = 0;
+
+  for (s = trace_sites; s < trace_sites + TRACE_SITE_CNT; s++)
+    {
+      if (s->disable_eip == trace_disable_eip || s->count == 0)
+        break;
+      if (min == NULL || s->max_cycles < min->max_cycles)
+        min = s;
+    }
+  if (s == trace_sites + TRACE_SITE_CNT)
+    {
+      if (cycles <= min->max_cycles)
+        {
+          trace_dropped++;
+          return;
+        }
+      trace_dropped += min->count;
+      s = min;
+      s->count = 0;
+    }
+  if (s->count == 0)
+    {
+      s->disable_eip = trace_disable_eip;
+      s->max_cycles = s->total_cycles = 0;
+    }
+
+  s->count++;
+  s->total_cycles += cycles;
+  if (cycles > s->max_cycles)
+    {
+      s->max_cycles = cycles;
+      s->enable_eip = enable_eip;
+    }
+}
+#endif
+
+/* Prints the call sites that kept interrupts off the longest,
+   longest first.  Does nothing unless INTR_TRACE is defined.
+   The addresses can be turned into function names with the
+   `backtrace' tool. */
+void
+intr_trace_print (void) 
+{
+#ifdef INTR_TRACE
+  struct trace_site sites[TRACE_SITE_CNT];
+  enum intr_level old_level;
+  int i, j;
+
+  /* Take a snapshot, so that printing does not disturb it. */
+  old_level = intr_disable ();
+  memcpy (sites, trace_sites, sizeof sites);
+  intr_set_level (old_level);
+
+  /* Sort by longest window: there are few enough entries that
+     insertion sort is fine. */
+  for (i = 1; i < TRACE_SITE_CNT; i++)
+    for (j = i; j > 0 && sites[j].max_cycles > sites[j - 1].max_cycles; j--)
+      {
+        struct trace_site tmp = sites[j];
+        sites[j] = sites[j - 1];
+        sites[j - 1] = tmp;
+      }
+
+  printf ("Interrupts-off windows, longest first (cycles):\n");
+  printf ("  %-10s %-10s %12s %12s %8s\n",
+          "off at", "on at", "max", "mean", "count");
+  for (i = 0; i < TRACE_SITE_CNT && sites[i].count > 0; i++)
+    printf ("  %-10p %-10p %12"PRIu64" %12"PRIu64" %8u\n",
+            sites[i].disable_eip, sites[i].enable_eip,
+            sites[i].max_cycles, sites[i].total_cycles / sites[i].count,
+            sites[i].count);
+  if (trace_dropped > 0)
+    printf ("  %u shorter windows not recorded.\n", trace_dropped);
+#endif
+}
 
 /* Initializes the interrupt system. */
 void
@@ -346,12 +511,24 @@ intr_handler (struct intr_frame *frame)
 {
   bool external;
   intr_handler_func *handler;
+  struct vector_stats *vs;
+  enum intr_level old_level;
+  uint64_t start, cycles;
 
   /* External interrupts are special.
      We only handle one at a time (so interrupts must be off)
      and they need to be acknowledged on the PIC (see below).
      An external interrupt handler cannot sleep. */
   external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+
+#ifdef INTR_TRACE
+  /* The interrupted code had interrupts on, so any window that
+     was being traced has ended, though not through intr_enable():
+     either an interrupt return or a thread switch reenabled
+     them. */
+  if (frame->eflags & FLAG_IF)
+    trace_start = 0;
+#endif
   if (external) 
     {
       ASSERT (intr_get_level () == INTR_OFF);
@@ -359,9 +536,14 @@ intr_handler (struct intr_frame *frame)
 
       in_external_intr = true;
       yield_on_return = false;
+
+      /* Leave tickless idle, if we were in it, before anything
+         looks at the time. */
+      timer_idle_exit ();
     }
 
   /* Invoke the interrupt's handler. */
+  start = rdtsc ();
   handler = intr_handlers[frame->vec_no];
   if (handler != NULL)
     handler (frame);
@@ -373,6 +555,20 @@ intr_handler (struct intr_frame *frame)
     }
   else
     unexpected_interrupt (frame);
+  cycles = rdtsc () - start;
+
+  /* Account for the invocation.  Internal interrupts may run with
+     interrupts on, so other invocations of the same vector could
+     otherwise interleave with the update. */
+  vs = &vector_stats[frame->vec_no];
+  old_level = intr_disable ();
+  vs->count++;
+  vs->total_cycles += cycles;
+  if (cycles > vs->max_cycles)
+    vs->max_cycles = cycles;
+  if (external && yield_on_return)
+    vs->yields++;
+  intr_set_level (old_level);
 
   /* Complete the processing of an external interrupt. */
   if (external) 
@@ -388,6 +584,42 @@ intr_handler (struct intr_frame *frame)
     }
 }
 
+/* Copies the statistics for interrupt vector VEC into ST. */
+void
+intr_get_stats (uint8_t vec, struct intrstat *st) 
+{
+  enum intr_level old_level;
+
+  strlcpy (st->name, intr_names[vec], sizeof st->name);
+  old_level = intr_disable ();
+  st->count = vector_stats[vec].count;
+  st->total_cycles = vector_stats[vec].total_cycles;
+  st->max_cycles = vector_stats[vec].max_cycles;
+  st->yields = vector_stats[vec].yields;
+  intr_set_level (old_level);
+}
+
+/* Prints statistics for every interrupt vector that has been
+   invoked at least once. */
+void
+intr_print_stats (void) 
+{
+  int vec;
+
+  for (vec = 0; vec < INTR_CNT; vec++)
+    {
+      struct intrstat st;
+
+      intr_get_stats (vec, &st);
+      if (st.count == 0)
+        continue;
+      printf ("Interrupt: %#04x %s: %"PRIu64" calls, %"PRIu64" cycles "
+              "(mean %"PRIu64", max %"PRIu64"), %u yields\n",
+              vec, st.name, st.count, st.total_cycles,
+              st.total_cycles / st.count, st.max_cycles, st.yields);
+    }
+}
+
 /* Handles an unexpected interrupt with interrupt frame F.  An
    unexpected interrupt is one that has no registered handler. */
 static void
@@ -1,6 +1,7 @@
 #ifndef THREADS_INTERRUPT_H
 #define THREADS_INTERRUPT_H
 
+#include <intrstat.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -15,6 +16,12 @@ enum intr_level intr_get_level (void);
 enum intr_level intr_set_level (enum intr_level);
 enum intr_level intr_enable (void);
 enum intr_level intr_disable (void);
+
+/* Interrupts-off latency tracing.  Collected only if the kernel
+   is built with INTR_TRACE defined, e.g. by adding -DINTR_TRACE
+   to DEFINES in Make.vars; otherwise intr_trace_print() does
+   nothing. */
+void intr_trace_print (void);
 
 /* Interrupt stack frame. */
 struct intr_frame
@@ -65,6 +72,8 @@ bool intr_context (void);
 void intr_yield_on_return (void);
 
 void intr_dump_frame (const struct intr_frame *);
+void intr_get_stats (uint8_t vec, struct intrstat *);
+void intr_print_stats (void);
 const char *intr_name (uint8_t vec);
 
 #endif /* threads/interrupt.h */
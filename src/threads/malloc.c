@@ -6,7 +6,10 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
@@ -26,21 +29,59 @@
    When we free a block, we add it to its descriptor's free list.
    But if the arena that the block was in now has no in-use
    blocks, we remove all of the arena's blocks from the free list
-   and give the arena back to the page allocator.
-
-   We can't handle blocks bigger than 2 kB using this scheme,
-   because they're too big to fit in a single page with a
-   descriptor.  We handle those by allocating contiguous pages
-   with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   and give the arena back to the page allocator, unless the
+   descriptor is keeping fewer than ARENA_KEEP empty arenas, in
+   which case the arena stays on hand for the next allocation.
+   That way a loop that allocates and frees one block does not
+   get and free a page every time around.
+
+   Taking the descriptor's lock on every malloc() and free() is
+   expensive, so each thread also keeps a "magazine" of free
+   blocks for each descriptor, which only it touches.  malloc()
+   takes a block from the magazine and free() puts one into it,
+   without locking.  Only when the magazine is empty, or full, do
+   we take the lock, to move half a magazine's worth of blocks
+   from, or to, the descriptor's free list at once.  Blocks in
+   magazines count as in use as far as their arenas are
+   concerned.  A thread's magazines are emptied when it exits.
+
+   We don't handle blocks bigger than 1 kB using this scheme,
+   because too few of them fit in a page.  We handle those "big
+   blocks" by allocating contiguous pages with the page allocator.
+   The allocation size goes in a struct big_block kept in a
+   separate table, not in the pages themselves, so that a request
+   for a multiple of PGSIZE bytes takes exactly that many pages.
+   Big blocks are page-aligned, and blocks from descriptors never
+   are, which is how free() tells them apart.  realloc() of a big
+   block shrinks it by freeing its last pages, and grows it in
+   place if the pages that follow it are free. */
+
+/* Most blocks in a magazine, and most bytes of blocks.  Every
+   magazine holds at least 2 blocks, so that refilling or
+   draining half of one moves at least 1. */
+#define MAG_BLOCKS 16
+#define MAG_BYTES 2048
+
+/* Number of empty arenas each descriptor keeps. */
+#define ARENA_KEEP 2
 
 /* Descriptor. */
 struct desc
   {
     size_t block_size;          /* Size of each element in bytes. */
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
+    size_t mag_size;            /* Max blocks in a magazine. */
     struct list free_list;      /* List of free blocks. */
+    size_t empty_cnt;           /* Arenas with no blocks in use. */
     struct lock lock;           /* Lock. */
+    char name[16];              /* Name of LOCK, for profiling. */
+
+    /* Statistics, protected by LOCK. */
+    unsigned long long refill_cnt;  /* Magazines refilled. */
+    unsigned long long drain_cnt;   /* Magazines drained. */
+    unsigned long long exited_hits; /* Magazine hits, exited threads. */
+    unsigned long long arena_cnt;   /* Arenas obtained. */
+    unsigned long long release_cnt; /* Arenas given back. */
   };
 
 /* Magic number for detecting arena corruption. */
@@ -50,28 +91,55 @@ struct desc
 struct arena 
   {
     unsigned magic;             /* Always set to ARENA_MAGIC. */
-    struct desc *desc;          /* Owning descriptor, null for big block. */
-    size_t free_cnt;            /* Free blocks; pages in big block. */
+    struct desc *desc;          /* Owning descriptor. */
+    size_t free_cnt;            /* Free blocks. */
   };
 
+/* Big block. */
+struct big_block
+  {
+    struct list_elem elem;      /* Element in big_buckets[]. */
+    void *pages;                /* First page. */
+    size_t page_cnt;            /* Number of pages. */
+  };
+
+/* Big blocks, hashed by page number.  A fixed table, because
+   growing a hash table would have to call malloc(). */
+#define BIG_BUCKETS 64
+static struct list big_buckets[BIG_BUCKETS];
+static struct lock big_lock;    /* Protects big_buckets and stats. */
+static struct kmem_cache *big_cache;
+
+/* Big block statistics. */
+static unsigned long long big_cnt;          /* Big blocks allocated. */
+static unsigned long long big_resize_cnt;   /* Resized in place. */
+
 /* Free block. */
 struct block 
   {
     struct list_elem free_elem; /* Free list element. */
+    struct block *mag_next;     /* Next block in a magazine. */
   };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[MALLOC_CLASSES]; /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static struct desc *desc_for (size_t size);
+static void *big_alloc (size_t page_cnt);
+static void big_free (void *);
+static struct big_block *big_lookup (void *);
+static bool refill (struct desc *, struct malloc_magazine *);
+static void drain (struct desc *, struct malloc_magazine *, size_t cnt);
 
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) 
 {
   size_t block_size;
+  size_t i;
 
   for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2)
     {
@@ -79,9 +147,22 @@ malloc_init (void)
       ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
       d->block_size = block_size;
       d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+      d->mag_size = MAG_BYTES / block_size;
+      if (d->mag_size > MAG_BLOCKS)
+        d->mag_size = MAG_BLOCKS;
       list_init (&d->free_list);
       lock_init (&d->lock);
+      snprintf (d->name, sizeof d->name, "malloc %zu", block_size);
+      lock_set_name (&d->lock, d->name);
     }
+  ASSERT (desc_cnt == MALLOC_CLASSES);
+
+  for (i = 0; i < BIG_BUCKETS; i++)
+    list_init (&big_buckets[i]);
+  lock_init (&big_lock);
+  lock_set_name (&big_lock, "malloc big");
+  big_cache = kmem_cache_create ("big_block", sizeof (struct big_block),
+                                 NULL);
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -90,66 +171,35 @@ void *
 malloc (size_t size) 
 {
   struct desc *d;
+  struct malloc_magazine *m;
   struct block *b;
-  struct arena *a;
+
+  ASSERT (!intr_context ());
 
   /* A null pointer satisfies a request for 0 bytes. */
   if (size == 0)
     return NULL;
 
   /* Find the smallest descriptor that satisfies a SIZE-byte
-     request. */
-  for (d = descs; d < descs + desc_cnt; d++)
-    if (d->block_size >= size)
-      break;
-  if (d == descs + desc_cnt) 
+     request.  If SIZE is too big for any descriptor, allocate
+     just enough pages to hold it. */
+  d = desc_for (size);
+  if (d == NULL)
+    return big_alloc (DIV_ROUND_UP (size, PGSIZE));
+
+  /* Take a block from our magazine, refilling it first if it
+     is empty. */
+  m = &thread_current ()->malloc_mags[d - descs];
+  if (m->cnt == 0)
     {
-      /* SIZE is too big for any descriptor.
-         Allocate enough pages to hold SIZE plus an arena. */
-      size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
-      a = palloc_get_multiple (0, page_cnt);
-      if (a == NULL)
+      if (!refill (d, m))
         return NULL;
-
-      /* Initialize the arena to indicate a big block of PAGE_CNT
-         pages, and return it. */
-      a->magic = ARENA_MAGIC;
-      a->desc = NULL;
-      a->free_cnt = page_cnt;
-      return a + 1;
     }
-
-  lock_acquire (&d->lock);
-
-  /* If the free list is empty, create a new arena. */
-  if (list_empty (&d->free_list))
-    {
-      size_t i;
-
-      /* Allocate a page. */
-      a = palloc_get_page (0);
-      if (a == NULL) 
-        {
-          lock_release (&d->lock);
-          return NULL; 
-        }
-
-      /* Initialize arena and add its blocks to the free list. */
-      a->magic = ARENA_MAGIC;
-      a->desc = d;
-      a->free_cnt = d->blocks_per_arena;
-      for (i = 0; i < d->blocks_per_arena; i++) 
-        {
-          struct block *b = arena_to_block (a, i);
-          list_push_back (&d->free_list, &b->free_elem);
-        }
-    }
-
-  /* Get a block from free list and return it. */
-  b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-  a = block_to_arena (b);
-  a->free_cnt--;
-  lock_release (&d->lock);
+  else
+    m->hits++;
+  b = m->head;
+  m->head = b->mag_next;
+  m->cnt--;
   return b;
 }
 
@@ -178,11 +228,53 @@ calloc (size_t a, size_t b)
 static size_t
 block_size (void *block) 
 {
-  struct block *b = block;
-  struct arena *a = block_to_arena (b);
-  struct desc *d = a->desc;
+  size_t size;
+
+  if (pg_ofs (block) != 0)
+    return block_to_arena (block)->desc->block_size;
 
-  return d != NULL ? d->block_size : PGSIZE * a->free_cnt - pg_ofs (block);
+  lock_acquire (&big_lock);
+  size = big_lookup (block)->page_cnt * PGSIZE;
+  lock_release (&big_lock);
+  return size;
+}
+
+/* Tries to resize BLOCK to NEW_SIZE bytes without moving it, and
+   returns true if successful.  A block from a descriptor stays
+   put if NEW_SIZE maps to the same descriptor.  A big block that
+   stays big gives back its last pages to shrink, or takes the
+   pages after it, if free, to grow. */
+static bool
+resize_in_place (void *block, size_t new_size)
+{
+  struct big_block *bb;
+  size_t new_cnt;
+  bool success;
+
+  if (pg_ofs (block) != 0)
+    return desc_for (new_size) == block_to_arena (block)->desc;
+  if (desc_for (new_size) != NULL)
+    return false;
+
+  new_cnt = DIV_ROUND_UP (new_size, PGSIZE);
+  lock_acquire (&big_lock);
+  bb = big_lookup (block);
+  if (new_cnt <= bb->page_cnt)
+    {
+      palloc_free_multiple ((uint8_t *) block + new_cnt * PGSIZE,
+                            bb->page_cnt - new_cnt);
+      success = true;
+    }
+  else
+    success = palloc_grow (block, bb->page_cnt, new_cnt);
+  if (success)
+    {
+      if (new_cnt != bb->page_cnt)
+        big_resize_cnt++;
+      bb->page_cnt = new_cnt;
+    }
+  lock_release (&big_lock);
+  return success;
 }
 
 /* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
@@ -199,6 +291,8 @@ realloc (void *old_block, size_t new_size)
       free (old_block);
       return NULL;
     }
+  else if (old_block != NULL && resize_in_place (old_block, new_size))
+    return old_block;
   else 
     {
       void *new_block = malloc (new_size);
@@ -218,51 +312,282 @@ realloc (void *old_block, size_t new_size)
 void
 free (void *p) 
 {
-  if (p != NULL)
+  struct block *b = p;
+  struct arena *a;
+  struct desc *d;
+  struct malloc_magazine *m;
+
+  if (p == NULL)
+    return;
+
+  ASSERT (!intr_context ());
+
+  if (pg_ofs (p) == 0)
     {
-      struct block *b = p;
-      struct arena *a = block_to_arena (b);
-      struct desc *d = a->desc;
-      
-      if (d != NULL) 
-        {
-          /* It's a normal block.  We handle it here. */
+      /* It's a big block.  Free its pages. */
+      big_free (p);
+      return;
+    }
+
+  /* It's a normal block.  We handle it here. */
+  a = block_to_arena (b);
+  d = a->desc;
 
 #ifndef NDEBUG
-          /* Clear the block to help detect use-after-free bugs. */
-          memset (b, 0xcc, d->block_size);
+  /* Clear the block to help detect use-after-free bugs. */
+  memset (b, 0xcc, d->block_size);
 #endif
-  
-          lock_acquire (&d->lock);
 
-          /* Add block to free list. */
-          list_push_front (&d->free_list, &b->free_elem);
+  /* Put the block in our magazine, draining half of it first if
+     it is full. */
+  m = &thread_current ()->malloc_mags[d - descs];
+  if (m->cnt >= d->mag_size)
+    drain (d, m, d->mag_size / 2);
+  else
+    m->hits++;
+  b->mag_next = m->head;
+  m->head = b;
+  m->cnt++;
+}
+
+/* Returns the smallest descriptor whose blocks hold SIZE bytes,
+   or a null pointer if SIZE needs a big block. */
+static struct desc *
+desc_for (size_t size)
+{
+  struct desc *d;
+
+  for (d = descs; d < descs + desc_cnt; d++)
+    if (d->block_size >= size)
+      return d;
+  return NULL;
+}
 
-          /* If the arena is now entirely unused, free it. */
-          if (++a->free_cnt >= d->blocks_per_arena) 
-            {
-              size_t i;
-
-              ASSERT (a->free_cnt == d->blocks_per_arena);
-              for (i = 0; i < d->blocks_per_arena; i++) 
-                {
-                  struct block *b = arena_to_block (a, i);
-                  list_remove (&b->free_elem);
-                }
-              palloc_free_page (a);
-            }
+/* Returns the list in big_buckets[] for a big block at PAGES. */
+static struct list *
+big_bucket (void *pages)
+{
+  return &big_buckets[pg_no (pages) % BIG_BUCKETS];
+}
 
-          lock_release (&d->lock);
+/* Returns the big block at PAGES, which must exist.  big_lock
+   must be held. */
+static struct big_block *
+big_lookup (void *pages)
+{
+  struct list *bucket = big_bucket (pages);
+  struct list_elem *e;
+
+  for (e = list_begin (bucket); e != list_end (bucket); e = list_next (e))
+    {
+      struct big_block *bb = list_entry (e, struct big_block, elem);
+      if (bb->pages == pages)
+        return bb;
+    }
+  PANIC ("free or realloc of %p, which is not a malloc() block", pages);
+}
+
+/* Allocates and returns a big block of PAGE_CNT pages, or a null
+   pointer if memory is not available. */
+static void *
+big_alloc (size_t page_cnt)
+{
+  struct big_block *bb = kmem_cache_alloc (big_cache);
+  if (bb == NULL)
+    return NULL;
+
+  bb->pages = palloc_get_multiple (0, page_cnt);
+  if (bb->pages == NULL)
+    {
+      kmem_cache_free (big_cache, bb);
+      return NULL;
+    }
+  bb->page_cnt = page_cnt;
+
+  lock_acquire (&big_lock);
+  list_push_front (big_bucket (bb->pages), &bb->elem);
+  big_cnt++;
+  lock_release (&big_lock);
+  return bb->pages;
+}
+
+/* Frees the big block at PAGES. */
+static void
+big_free (void *pages)
+{
+  struct big_block *bb;
+
+  lock_acquire (&big_lock);
+  bb = big_lookup (pages);
+  list_remove (&bb->elem);
+  lock_release (&big_lock);
+
+  palloc_free_multiple (bb->pages, bb->page_cnt);
+  kmem_cache_free (big_cache, bb);
+}
+
+/* Returns every block in the running thread's magazines to its
+   descriptor.  Called when the thread exits. */
+void
+malloc_thread_exit (void)
+{
+  struct thread *cur = thread_current ();
+  size_t i;
+
+  for (i = 0; i < desc_cnt; i++)
+    {
+      struct malloc_magazine *m = &cur->malloc_mags[i];
+      if (m->cnt > 0)
+        drain (&descs[i], m, m->cnt);
+      if (m->hits > 0)
+        {
+          lock_acquire (&descs[i].lock);
+          descs[i].exited_hits += m->hits;
+          lock_release (&descs[i].lock);
+          m->hits = 0;
         }
+    }
+}
+
+/* Adds thread T's magazine hits to the array HITS.
+   Used by malloc_print_stats() via thread_foreach(). */
+static void
+add_hits (struct thread *t, void *hits_)
+{
+  unsigned long long *hits = hits_;
+  size_t i;
+
+  for (i = 0; i < desc_cnt; i++)
+    hits[i] += t->malloc_mags[i].hits;
+}
+
+/* Prints malloc() statistics.  A magazine hit is a malloc() or
+   free() that did not need to take the descriptor's lock. */
+void
+malloc_print_stats (void)
+{
+  unsigned long long hits[MALLOC_CLASSES];
+  enum intr_level old_level;
+  size_t i;
+
+  for (i = 0; i < desc_cnt; i++)
+    hits[i] = descs[i].exited_hits;
+  old_level = intr_disable ();
+  thread_foreach (add_hits, hits);
+  intr_set_level (old_level);
+
+  for (i = 0; i < desc_cnt; i++)
+    {
+      struct desc *d = &descs[i];
+      if (d->arena_cnt == 0)
+        continue;
+      printf ("Malloc: %zu-byte blocks: %llu lock acquisitions avoided, "
+              "%llu refills, %llu drains, %llu of %llu arenas released\n",
+              d->block_size, hits[i], d->refill_cnt, d->drain_cnt,
+              d->release_cnt, d->arena_cnt);
+    }
+  if (big_cnt != 0)
+    printf ("Malloc: big blocks: %llu allocated, %llu resized in place\n",
+            big_cnt, big_resize_cnt);
+}
+
+/* Obtains a new arena for D and adds its blocks to D's free
+   list.  Returns false if no page is available.  D's lock must
+   be held. */
+static bool
+new_arena (struct desc *d)
+{
+  struct arena *a = palloc_get_page (0);
+  size_t i;
+
+  if (a == NULL)
+    return false;
+
+  a->magic = ARENA_MAGIC;
+  a->desc = d;
+  a->free_cnt = d->blocks_per_arena;
+  for (i = 0; i < d->blocks_per_arena; i++) 
+    {
+      struct block *b = arena_to_block (a, i);
+      list_push_back (&d->free_list, &b->free_elem);
+    }
+  d->empty_cnt++;
+  d->arena_cnt++;
+  return true;
+}
+
+/* Moves up to half of a magazine's worth of blocks from D's free
+   list into empty magazine M, creating a new arena if there are
+   none.  Returns false if out of memory. */
+static bool
+refill (struct desc *d, struct malloc_magazine *m)
+{
+  size_t want = d->mag_size / 2;
+
+  ASSERT (m->cnt == 0);
+
+  lock_acquire (&d->lock);
+  d->refill_cnt++;
+  if (list_empty (&d->free_list) && !new_arena (d))
+    {
+      lock_release (&d->lock);
+      return false;
+    }
+  while (m->cnt < want && !list_empty (&d->free_list))
+    {
+      struct block *b = list_entry (list_pop_front (&d->free_list),
+                                    struct block, free_elem);
+      struct arena *a = block_to_arena (b);
+      if (a->free_cnt-- == d->blocks_per_arena)
+        d->empty_cnt--;
+      b->mag_next = m->head;
+      m->head = b;
+      m->cnt++;
+    }
+  lock_release (&d->lock);
+  return true;
+}
+
+/* Moves CNT blocks from magazine M back to D's free list.  If
+   that leaves an arena unused, keeps it if D has fewer than
+   ARENA_KEEP empty arenas, and otherwise frees it. */
+static void
+drain (struct desc *d, struct malloc_magazine *m, size_t cnt)
+{
+  ASSERT (cnt <= m->cnt);
+
+  lock_acquire (&d->lock);
+  d->drain_cnt++;
+  for (; cnt > 0; cnt--)
+    {
+      struct block *b = m->head;
+      struct arena *a = block_to_arena (b);
+
+      m->head = b->mag_next;
+      m->cnt--;
+      list_push_front (&d->free_list, &b->free_elem);
+      if (++a->free_cnt < d->blocks_per_arena)
+        continue;
+
+      ASSERT (a->free_cnt == d->blocks_per_arena);
+      if (d->empty_cnt < ARENA_KEEP)
+        d->empty_cnt++;
       else
         {
-          /* It's a big block.  Free its pages. */
-          palloc_free_multiple (a, a->free_cnt);
-          return;
+          size_t i;
+
+          for (i = 0; i < d->blocks_per_arena; i++) 
+            {
+              struct block *b = arena_to_block (a, i);
+              list_remove (&b->free_elem);
+            }
+          palloc_free_page (a);
+          d->release_cnt++;
         }
     }
+  lock_release (&d->lock);
 }
-
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b)
@@ -274,9 +599,8 @@ block_to_arena (struct block *b)
   ASSERT (a->magic == ARENA_MAGIC);
 
   /* Check that the block is properly aligned for the arena. */
-  ASSERT (a->desc == NULL
-          || (pg_ofs (b) - sizeof *a) % a->desc->block_size == 0);
-  ASSERT (a->desc != NULL || pg_ofs (b) == sizeof *a);
+  ASSERT (a->desc != NULL);
+  ASSERT ((pg_ofs (b) - sizeof *a) % a->desc->block_size == 0);
 
   return a;
 }
@@ -4,10 +4,24 @@
 #include <debug.h>
 #include <stddef.h>
 
+/* Number of malloc() block sizes, 16 bytes through 1 kB.
+   Larger requests are satisfied with whole pages. */
+#define MALLOC_CLASSES 7
+
+/* A thread's cache of free blocks of one size.  See malloc.c. */
+struct malloc_magazine
+  {
+    void *head;                 /* First free block. */
+    unsigned cnt;               /* Number of free blocks. */
+    unsigned hits;              /* Calls served without locking. */
+  };
+
 void malloc_init (void);
 void *malloc (size_t) __attribute__ ((malloc));
 void *calloc (size_t, size_t) __attribute__ ((malloc));
 void *realloc (void *, size_t);
 void free (void *);
+void malloc_thread_exit (void);
+void malloc_print_stats (void);
 
 #endif /* threads/malloc.h */
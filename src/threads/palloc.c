@@ -2,13 +2,14 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -25,12 +26,51 @@
    half to the user pool.  That should be huge overkill for the
    kernel pool, but that's just fine for demonstration purposes. */
 
-/* A memory pool. */
+/* Marks a page that does not start a free block in free_order. */
+#define NOT_FREE 0xff
+
+/* A memory pool.
+
+   Free pages are managed by a binary buddy allocator.  Each
+   free block of order K is on free_lists[K], linked through a
+   struct free_block at its start, and its first page's entry in
+   free_order is K.  Allocation splits the smallest large enough
+   block in halves until it is the right size, and freeing merges
+   a block with its "buddy", the other half of the block it was
+   split from, for as long as the buddy is free too.  Both take
+   O(log n) time for a pool of n pages.
+
+   used_map has a bit for each page, set if the page is
+   allocated.  It only serves to catch bad frees.
+
+   The kernel and user pools are protected by turning interrupts
+   off rather than by a lock, because thread_schedule_tail()
+   frees the page of a dying thread from inside the scheduler,
+   where sleeping is not allowed.  (Private pools, created with
+   palloc_create_pool(), are left to their owners.)  Every operation under it takes O(log n) time, except
+   for multi-page frees and grows, which are linear in the number
+   of pages. */
 struct pool
   {
-    struct lock lock;                   /* Mutual exclusion. */
-    struct bitmap *used_map;            /* Bitmap of free pages. */
+    struct bitmap *used_map;            /* Bitmap of used pages. */
+    uint8_t *free_order;                /* Order of free block at page. */
     uint8_t *base;                      /* Base of pool. */
+    size_t page_cnt;                    /* Number of pages in pool. */
+    struct list free_lists[PALLOC_ORDERS]; /* Free blocks by order. */
+
+    /* Statistics. */
+    size_t free_cnt;                    /* Free pages. */
+    size_t block_cnt[PALLOC_ORDERS];    /* Free blocks of each order. */
+    unsigned long long alloc_cnt;       /* Successful allocations. */
+    unsigned long long fail_cnt;        /* Failed allocations. */
+    unsigned long long split_cnt;       /* Blocks split in two. */
+    unsigned long long merge_cnt;       /* Buddies merged. */
+  };
+
+/* Header at the start of a free block. */
+struct free_block
+  {
+    struct list_elem elem;              /* Element in free_lists. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -39,6 +79,10 @@ static struct pool kernel_pool, user_pool;
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static struct pool *pool_of (void *page);
+static size_t alloc_pages (struct pool *, size_t page_cnt);
+static void free_pages (struct pool *, size_t page_idx, size_t page_cnt);
+static void claim_pages (struct pool *, size_t page_idx, size_t page_cnt);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -71,15 +115,16 @@ void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  enum intr_level old_level;
   void *pages;
   size_t page_idx;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
+  old_level = intr_disable ();
+  page_idx = alloc_pages (pool, page_cnt);
+  intr_set_level (old_level);
 
   if (page_idx != BITMAP_ERROR)
     pages = pool->base + PGSIZE * page_idx;
@@ -113,32 +158,30 @@ palloc_get_page (enum palloc_flags flags)
   return palloc_get_multiple (flags, 1);
 }
 
-/* Frees the PAGE_CNT pages starting at PAGES. */
+/* Frees the PAGE_CNT pages starting at PAGES.  These need not
+   be all the pages obtained by one palloc_get_multiple() call:
+   freeing the last pages of a group shrinks it in place. */
 void
 palloc_free_multiple (void *pages, size_t page_cnt) 
 {
   struct pool *pool;
+  enum intr_level old_level;
   size_t page_idx;
 
   ASSERT (pg_ofs (pages) == 0);
   if (pages == NULL || page_cnt == 0)
     return;
 
-  if (page_from_pool (&kernel_pool, pages))
-    pool = &kernel_pool;
-  else if (page_from_pool (&user_pool, pages))
-    pool = &user_pool;
-  else
-    NOT_REACHED ();
-
+  pool = pool_of (pages);
   page_idx = pg_no (pages) - pg_no (pool->base);
 
 #ifndef NDEBUG
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
-  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  old_level = intr_disable ();
+  free_pages (pool, page_idx, page_cnt);
+  intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -148,25 +191,370 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Tries to extend the group of PAGE_CNT pages at PAGES, obtained
+   from palloc_get_multiple(), to NEW_PAGE_CNT pages in place, by
+   allocating the pages that follow it.  Returns true if
+   successful, false if any of those pages is in use or outside
+   the pool.  The added pages are not zeroed. */
+bool
+palloc_grow (void *pages, size_t page_cnt, size_t new_page_cnt)
+{
+  struct pool *pool;
+  enum intr_level old_level;
+  size_t page_idx, grow_cnt;
+  bool success;
+
+  ASSERT (pages != NULL && pg_ofs (pages) == 0);
+  ASSERT (new_page_cnt >= page_cnt);
+
+  pool = pool_of (pages);
+  page_idx = pg_no (pages) - pg_no (pool->base) + page_cnt;
+  grow_cnt = new_page_cnt - page_cnt;
+
+  old_level = intr_disable ();
+  success = (page_idx + grow_cnt <= pool->page_cnt
+             && bitmap_none (pool->used_map, page_idx, grow_cnt));
+  if (success)
+    claim_pages (pool, page_idx, grow_cnt);
+  intr_set_level (old_level);
+
+  return success;
+}
+
+/* Copies POOL's statistics into *STATS. */
+static void
+read_stats (const struct pool *pool, struct palloc_stats *stats)
+{
+  int order;
+
+  stats->page_cnt = pool->page_cnt;
+  stats->free_cnt = pool->free_cnt;
+  stats->largest_free = 0;
+  for (order = 0; order < PALLOC_ORDERS; order++)
+    {
+      stats->block_cnt[order] = pool->block_cnt[order];
+      if (pool->block_cnt[order] != 0)
+        stats->largest_free = (size_t) 1 << order;
+    }
+  stats->alloc_cnt = pool->alloc_cnt;
+  stats->fail_cnt = pool->fail_cnt;
+  stats->split_cnt = pool->split_cnt;
+  stats->merge_cnt = pool->merge_cnt;
+}
+
+/* Fills in *STATS for the user pool if PAL_USER is set in
+   FLAGS, otherwise for the kernel pool. */
+void
+palloc_get_stats (enum palloc_flags flags, struct palloc_stats *stats)
+{
+  struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  read_stats (pool, stats);
+  intr_set_level (old_level);
+}
+
+/* Prints statistics for POOL, named NAME.  Does not disable
+   interrupts, since we may be shutting down after a panic. */
+static void
+print_pool_stats (const struct pool *pool, const char *name)
+{
+  struct palloc_stats s;
+
+  read_stats (pool, &s);
+  printf ("%s: %zu of %zu pages free, largest free block %zu pages, "
+          "%zu%% fragmented\n",
+          name, s.free_cnt, s.page_cnt, s.largest_free,
+          s.free_cnt != 0 ? 100 - s.largest_free * 100 / s.free_cnt : 0);
+  printf ("%s: %llu allocations, %llu failed, %llu splits, %llu merges\n",
+          name, s.alloc_cnt, s.fail_cnt, s.split_cnt, s.merge_cnt);
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void)
+{
+  print_pool_stats (&kernel_pool, "Kernel pool");
+  print_pool_stats (&user_pool, "User pool");
+}
+
+/* Creates a private pool out of the PAGE_CNT pages at BASE,
+   which must be page-aligned, and returns it.  The pool's own
+   header and metadata take up its first few pages.  The pages
+   belong to the pool until the caller stops using it; nothing
+   needs to be released. */
+struct pool *
+palloc_create_pool (void *base, size_t page_cnt, const char *name)
+{
+  struct pool *p = base;
+  size_t header_pages = DIV_ROUND_UP (sizeof *p, PGSIZE);
+
+  ASSERT (pg_ofs (base) == 0);
+  if (header_pages > page_cnt)
+    PANIC ("Not enough memory in %s for header.", name);
+  init_pool (p, (uint8_t *) base + header_pages * PGSIZE,
+             page_cnt - header_pages, name);
+  return p;
+}
+
+/* Obtains PAGE_CNT contiguous pages from private pool POOL and
+   returns the address of the first, or a null pointer if no
+   free block is large enough.  The pages are not zeroed. */
+void *
+palloc_pool_get (struct pool *pool, size_t page_cnt)
+{
+  size_t page_idx;
+
+  if (page_cnt == 0)
+    return NULL;
+  page_idx = alloc_pages (pool, page_cnt);
+  return page_idx != BITMAP_ERROR ? pool->base + PGSIZE * page_idx : NULL;
+}
+
+/* Frees the PAGE_CNT pages at PAGES, obtained from private pool
+   POOL. */
+void
+palloc_pool_free (struct pool *pool, void *pages, size_t page_cnt)
+{
+  ASSERT (pg_ofs (pages) == 0);
+  if (pages == NULL || page_cnt == 0)
+    return;
+  ASSERT (page_from_pool (pool, pages));
+  free_pages (pool, pg_no (pages) - pg_no (pool->base), page_cnt);
+}
+
+/* Fills in *STATS for private pool POOL. */
+void
+palloc_pool_get_stats (struct pool *pool, struct palloc_stats *stats)
+{
+  read_stats (pool, stats);
+}
+
+/* Returns the order of the smallest block of at least PAGE_CNT
+   pages. */
+static int
+order_for (size_t page_cnt)
+{
+  int order = 0;
+  while (((size_t) 1 << order) < page_cnt)
+    order++;
+  return order;
+}
+
+/* Returns the free block header of POOL's page PAGE_IDX. */
+static struct free_block *
+block_at (const struct pool *pool, size_t page_idx)
+{
+  return (struct free_block *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Adds the free block of order ORDER at PAGE_IDX to POOL's free
+   lists. */
+static void
+push_block (struct pool *pool, size_t page_idx, int order)
+{
+  list_push_front (&pool->free_lists[order],
+                   &block_at (pool, page_idx)->elem);
+  pool->free_order[page_idx] = order;
+  pool->block_cnt[order]++;
+}
+
+/* Removes the free block of order ORDER at PAGE_IDX from POOL's
+   free lists. */
+static void
+remove_block (struct pool *pool, size_t page_idx, int order)
+{
+  ASSERT (pool->free_order[page_idx] == order);
+  list_remove (&block_at (pool, page_idx)->elem);
+  pool->free_order[page_idx] = NOT_FREE;
+  pool->block_cnt[order]--;
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first, or BITMAP_ERROR if no block is large
+   enough.  Interrupts must be off. */
+static size_t
+alloc_pages (struct pool *pool, size_t page_cnt)
+{
+  int want = order_for (page_cnt);
+  int order;
+  struct free_block *b;
+  size_t page_idx;
+
+  /* Find the smallest free block that is large enough. */
+  for (order = want; order < PALLOC_ORDERS; order++)
+    if (!list_empty (&pool->free_lists[order]))
+      break;
+  if (order >= PALLOC_ORDERS)
+    {
+      pool->fail_cnt++;
+      return BITMAP_ERROR;
+    }
+  b = list_entry (list_front (&pool->free_lists[order]),
+                  struct free_block, elem);
+  page_idx = pg_no (b) - pg_no (pool->base);
+  remove_block (pool, page_idx, order);
+
+  /* Split it down to size, keeping the lower half each time. */
+  while (order > want)
+    {
+      order--;
+      push_block (pool, page_idx + ((size_t) 1 << order), order);
+      pool->split_cnt++;
+    }
+
+  ASSERT (bitmap_none (pool->used_map, page_idx, (size_t) 1 << want));
+  bitmap_set_multiple (pool->used_map, page_idx, (size_t) 1 << want, true);
+  pool->free_cnt -= (size_t) 1 << want;
+  pool->alloc_cnt++;
+
+  /* Give back the pages past PAGE_CNT, so that requests that
+     are not a power of 2 do not waste up to half their block. */
+  if (page_cnt < (size_t) 1 << want)
+    free_pages (pool, page_idx + page_cnt, ((size_t) 1 << want) - page_cnt);
+
+  return page_idx;
+}
+
+/* Frees the block of order ORDER at PAGE_IDX in POOL, merging
+   it with its buddy as many times as possible. */
+static void
+free_block (struct pool *pool, size_t page_idx, int order)
+{
+  while (order < PALLOC_ORDERS - 1)
+    {
+      size_t buddy_idx = page_idx ^ ((size_t) 1 << order);
+      if (buddy_idx + ((size_t) 1 << order) > pool->page_cnt
+          || pool->free_order[buddy_idx] != order)
+        break;
+      remove_block (pool, buddy_idx, order);
+      pool->merge_cnt++;
+      if (buddy_idx < page_idx)
+        page_idx = buddy_idx;
+      order++;
+    }
+  push_block (pool, page_idx, order);
+}
+
+/* Adds the PAGE_CNT pages at PAGE_IDX in POOL to its free lists,
+   as the largest aligned blocks that fit. */
+static void
+add_free_range (struct pool *pool, size_t page_idx, size_t page_cnt)
+{
+  while (page_cnt > 0)
+    {
+      int order = 0;
+      while (order < PALLOC_ORDERS - 1
+             && page_idx % ((size_t) 2 << order) == 0
+             && ((size_t) 2 << order) <= page_cnt)
+        order++;
+      free_block (pool, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Frees the PAGE_CNT pages at PAGE_IDX in POOL, which need not
+   be a block that alloc_pages() returned, as long as every page
+   is allocated.  Interrupts must be off. */
+static void
+free_pages (struct pool *pool, size_t page_idx, size_t page_cnt)
+{
+  ASSERT (page_idx + page_cnt <= pool->page_cnt);
+  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
+  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  pool->free_cnt += page_cnt;
+  add_free_range (pool, page_idx, page_cnt);
+}
+
+/* Allocates the PAGE_CNT pages at PAGE_IDX in POOL, all of which
+   must be free.  Each free block that overlaps the range is
+   taken off its free list, and its pages outside the range are
+   put back as smaller blocks.  Interrupts must be off. */
+static void
+claim_pages (struct pool *pool, size_t page_idx, size_t page_cnt)
+{
+  size_t end = page_idx + page_cnt;
+  size_t idx = page_idx;
+
+  ASSERT (end <= pool->page_cnt);
+  ASSERT (bitmap_none (pool->used_map, page_idx, page_cnt));
+
+  while (idx < end)
+    {
+      size_t head, block_end, claim_end;
+      int order;
+
+      /* Find the free block that contains page IDX. */
+      for (order = 0; ; order++)
+        {
+          ASSERT (order < PALLOC_ORDERS);
+          head = idx & ~(((size_t) 1 << order) - 1);
+          if (pool->free_order[head] == order)
+            break;
+        }
+      remove_block (pool, head, order);
+      block_end = head + ((size_t) 1 << order);
+      claim_end = end < block_end ? end : block_end;
+
+      add_free_range (pool, head, idx - head);
+      add_free_range (pool, claim_end, block_end - claim_end);
+      pool->split_cnt++;
+      idx = claim_end;
+    }
+
+  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+  pool->free_cnt -= page_cnt;
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
+  /* We'll put the pool's used_map and free_order at its base.
+     Calculate the space needed for them and subtract it from the
+     pool's size. */
+  size_t bm_size = bitmap_buf_size (page_cnt);
+  size_t meta_pages = DIV_ROUND_UP (bm_size + page_cnt, PGSIZE);
+  int order;
+
+  if (meta_pages > page_cnt)
     PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  page_cnt -= meta_pages;
 
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
-  /* Initialize the pool. */
-  lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  /* Initialize the pool, with every page allocated. */
+  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_size);
+  bitmap_set_all (p->used_map, true);
+  p->free_order = (uint8_t *) base + bm_size;
+  memset (p->free_order, NOT_FREE, page_cnt);
+  p->base = (uint8_t *) base + meta_pages * PGSIZE;
+  p->page_cnt = page_cnt;
+  for (order = 0; order < PALLOC_ORDERS; order++)
+    {
+      list_init (&p->free_lists[order]);
+      p->block_cnt[order] = 0;
+    }
+  p->free_cnt = 0;
+  p->alloc_cnt = p->fail_cnt = p->split_cnt = p->merge_cnt = 0;
+
+  /* Then free them all. */
+  free_pages (p, 0, page_cnt);
+}
+
+/* Returns the pool that PAGE was allocated from. */
+static struct pool *
+pool_of (void *page)
+{
+  if (page_from_pool (&kernel_pool, page))
+    return &kernel_pool;
+  else if (page_from_pool (&user_pool, page))
+    return &user_pool;
+  else
+    NOT_REACHED ();
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -176,7 +564,7 @@ page_from_pool (const struct pool *pool, void *page)
 {
   size_t page_no = pg_no (page);
   size_t start_page = pg_no (pool->base);
-  size_t end_page = start_page + bitmap_size (pool->used_map);
+  size_t end_page = start_page + pool->page_cnt;
 
   return page_no >= start_page && page_no < end_page;
 }
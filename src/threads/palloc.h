@@ -1,8 +1,13 @@
 #ifndef THREADS_PALLOC_H
 #define THREADS_PALLOC_H
 
+#include <stdbool.h>
 #include <stddef.h>
 
+/* Number of buddy allocator block sizes.  A block of order K is
+   2**K pages, so the largest is 2**(PALLOC_ORDERS - 1) pages. */
+#define PALLOC_ORDERS 20
+
 /* How to allocate pages. */
 enum palloc_flags
   {
@@ -11,10 +16,37 @@ enum palloc_flags
     PAL_USER = 004              /* User page. */
   };
 
+/* Page allocator statistics for one pool. */
+struct palloc_stats
+  {
+    size_t page_cnt;                    /* Pages in pool. */
+    size_t free_cnt;                    /* Free pages. */
+    size_t largest_free;                /* Pages in largest free block. */
+    size_t block_cnt[PALLOC_ORDERS];    /* Free blocks of each order. */
+    unsigned long long alloc_cnt;       /* Successful allocations. */
+    unsigned long long fail_cnt;        /* Failed allocations. */
+    unsigned long long split_cnt;       /* Blocks split in two. */
+    unsigned long long merge_cnt;       /* Buddies merged. */
+  };
+
 void palloc_init (size_t user_page_limit);
 void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+bool palloc_grow (void *, size_t page_cnt, size_t new_page_cnt);
+void palloc_get_stats (enum palloc_flags, struct palloc_stats *);
+void palloc_print_stats (void);
+
+/* Private pools hand out the pages of a region that the caller
+   owns, with the same allocator as the kernel and user pools.
+   They exist for testing and benchmarking the allocator.  The
+   caller must serialize access to a private pool. */
+struct pool;
+struct pool *palloc_create_pool (void *base, size_t page_cnt,
+                                 const char *name);
+void *palloc_pool_get (struct pool *, size_t page_cnt);
+void palloc_pool_free (struct pool *, void *pages, size_t page_cnt);
+void palloc_pool_get_stats (struct pool *, struct palloc_stats *);
 
 #endif /* threads/palloc.h */
@@ -0,0 +1,251 @@
+/* Earliest-deadline-first real-time scheduling.
+
+   A thread joins this class by calling thread_set_deadline()
+   with a period and a budget, both in timer ticks.  From then on
+   it is entitled to BUDGET ticks of CPU time in every PERIOD
+   ticks, with each period's share due by the period's end, its
+   deadline.  EDF threads run ahead of all threads of the active
+   scheduling class, whatever their priorities, and among
+   themselves the ready thread with the earliest deadline runs.
+
+   Admission control keeps the sum of budget / period over all
+   EDF threads at or below EDF_UTIL_MAX.  Under that bound, EDF
+   meets every deadline, and the remainder of the CPU is left to
+   the other threads.  Budgets are enforced at each timer tick: a
+   thread that has used up its budget is throttled, parked off
+   the run queue until its next period begins, even if it still
+   wants to run.
+
+   A thread that is still runnable at its deadline without having
+   had its budget has missed the deadline; thread_get_deadline_
+   misses() reports how often.  A thread that blocks instead gives
+   up the rest of its period.  When it wakes up after its
+   deadline, it starts a fresh period then and there.
+
+   Periods of running threads advance in thread_tick(), those of
+   throttled threads in a timer event at their deadline, and
+   those of other ready threads when they are picked to run.
+
+   See C. L. Liu and J. W. Layland, "Scheduling Algorithms for
+   Multiprogramming in a Hard-Real-Time Environment", JACM 20(1),
+   1973. */
+
+#include "threads/sched.h"
+#include <debug.h>
+#include <heap.h>
+#include <round.h>
+#include <stddef.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Utilization is counted in parts per EDF_UTIL_SCALE. */
+#define EDF_UTIL_SCALE 1000000
+
+/* Most of the CPU that EDF threads may reserve together. */
+#define EDF_UTIL_MAX (EDF_UTIL_SCALE / 100 * 95)
+
+/* Ready EDF threads that have budget left, earliest deadline
+   first. */
+static struct heap run_queue;
+
+/* Utilization reserved by all EDF threads. */
+static int total_util;
+
+static heap_less_func deadline_less;
+static void replenish (struct timer_event *);
+
+/* Orders threads A and B by ascending deadline.  Threads with
+   equal deadlines run in the order they became ready. */
+static bool
+deadline_less (const struct heap_elem *a, const struct heap_elem *b,
+               void *aux UNUSED)
+{
+  return (heap_entry (a, struct thread, sched_elem)->deadline
+          < heap_entry (b, struct thread, sched_elem)->deadline);
+}
+
+/* Returns the utilization of a thread with PERIOD and BUDGET,
+   rounded up. */
+static int
+utilization (int period, int budget)
+{
+  return DIV_ROUND_UP ((int64_t) budget * EDF_UTIL_SCALE, period);
+}
+
+/* Reserves the utilization of a thread with PERIOD and BUDGET.
+   Returns true if successful, false if that would overload the
+   CPU.  Interrupts must be off. */
+bool
+sched_edf_reserve (int period, int budget)
+{
+  int util = utilization (period, budget);
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (total_util + util > EDF_UTIL_MAX)
+    return false;
+  total_util += util;
+  return true;
+}
+
+/* Releases the utilization reserved by sched_edf_reserve() for a
+   thread with PERIOD and BUDGET.  Interrupts must be off. */
+void
+sched_edf_release (int period, int budget)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  total_util -= utilization (period, budget);
+  ASSERT (total_util >= 0);
+}
+
+/* Starts T's next period, or if T has fallen behind by more than
+   that, the period that contains NOW. */
+static void
+next_period (struct thread *t, int64_t now)
+{
+  do
+    t->deadline += t->edf_period;
+  while (t->deadline <= now);
+  t->edf_used = 0;
+}
+
+/* Parks T, which has used up its budget, until its deadline. */
+static void
+throttle (struct thread *t)
+{
+  t->edf_throttled = true;
+  timer_event_init (&t->edf_event, replenish);
+  timer_event_add (&t->edf_event, t->deadline);
+}
+
+/* Timer event that ends a throttled thread's period and returns
+   it to the run queue if it is ready.  The timer interrupt then
+   preempts the running thread if need be. */
+static void
+replenish (struct timer_event *e)
+{
+  struct thread *t = (struct thread *) ((uint8_t *) e
+                                        - offsetof (struct thread, edf_event));
+
+  ASSERT (t->edf_throttled);
+
+  t->edf_throttled = false;
+  next_period (t, timer_ticks ());
+  if (t->status == THREAD_READY)
+    heap_insert (&run_queue, &t->sched_elem);
+}
+
+static void
+edf_init (void)
+{
+  heap_init (&run_queue, deadline_less, NULL);
+  total_util = 0;
+}
+
+/* A thread that has used up its budget waits for its next
+   period.  One that slept through its deadline starts a new
+   period now. */
+static void
+edf_enqueue (struct thread *t)
+{
+  int64_t now = timer_ticks ();
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (t->edf_throttled)
+    return;
+  if (t->deadline <= now)
+    {
+      t->deadline = now + t->edf_period;
+      t->edf_used = 0;
+    }
+  heap_insert (&run_queue, &t->sched_elem);
+}
+
+/* Ready threads whose deadlines passed while they waited have
+   missed them, and move on to their next period. */
+static struct thread *
+edf_pick_next (void)
+{
+  int64_t now = timer_ticks ();
+  struct heap_elem *e;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while ((e = heap_top (&run_queue)) != NULL)
+    {
+      struct thread *t = heap_entry (e, struct thread, sched_elem);
+
+      if (t->deadline > now)
+        break;
+      t->deadline_misses++;
+      next_period (t, now);
+      heap_update (&run_queue, e);
+    }
+
+  e = heap_pop (&run_queue);
+  return e != NULL ? heap_entry (e, struct thread, sched_elem) : NULL;
+}
+
+/* Any ready EDF thread preempts a thread of another class, and
+   an earlier deadline preempts a later one. */
+static bool
+edf_preempt (const struct thread *cur)
+{
+  struct heap_elem *e = heap_top (&run_queue);
+
+  if (e == NULL)
+    return false;
+  return (cur->edf_period == 0
+          || heap_entry (e, struct thread, sched_elem)->deadline
+             < cur->deadline);
+}
+
+/* Charges the tick to CUR's budget.  If that ends CUR's period,
+   CUR missed its deadline unless it got its whole budget, and
+   goes on into its next period; otherwise, CUR is throttled once
+   its budget is gone. */
+static bool
+edf_tick (struct thread *cur, unsigned slice_ticks UNUSED)
+{
+  int64_t now = timer_ticks ();
+
+  cur->edf_used++;
+  if (cur->deadline <= now)
+    {
+      if (cur->edf_used < cur->edf_budget)
+        cur->deadline_misses++;
+      next_period (cur, now);
+      return edf_preempt (cur);
+    }
+  if (cur->edf_used >= cur->edf_budget)
+    {
+      throttle (cur);
+      return true;
+    }
+  return false;
+}
+
+/* Priorities, including donated ones, do not affect EDF
+   threads. */
+static void
+edf_set_priority (struct thread *t, int priority)
+{
+  t->priority = priority;
+}
+
+/* Earliest-deadline-first scheduling of periodic threads.  Not
+   selectable with "-sched": it runs alongside the active
+   class. */
+const struct sched_class sched_edf_class =
+  {
+    .name = "edf",
+    .init = edf_init,
+    .enqueue = edf_enqueue,
+    .pick_next = edf_pick_next,
+    .preempt = edf_preempt,
+    .tick = edf_tick,
+    .set_priority = edf_set_priority,
+  };
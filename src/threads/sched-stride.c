@@ -0,0 +1,119 @@
+/* Stride scheduling.
+
+   Each thread holds some number of tickets, and gets a share of
+   the CPU proportional to its tickets among the ready threads.
+   A thread's stride is STRIDE1 divided by its tickets, and its
+   pass advances by its stride for every tick that it runs.  The
+   scheduler always runs the ready thread with the smallest pass,
+   for one tick at a time, so the shares stay within a tick of
+   exact at all times.  See C. A. Waldspurger and W. E. Weihl,
+   "Stride Scheduling: Deterministic Proportional-Share Resource
+   Management", MIT/LCS/TM-528, 1995.
+
+   Priorities, including donated ones, are ignored.
+
+   A thread that blocks stops advancing while everyone else goes
+   on, so when it becomes ready again its pass is raised to at
+   least global_pass, the pass of the thread most recently
+   scheduled.  Otherwise it could claim all the CPU time it did
+   not use while it slept. */
+
+#include "threads/sched.h"
+#include <debug.h>
+#include <heap.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Pass advanced by one tick at one ticket. */
+#define STRIDE1 (1 << 20)
+
+/* Ticks to run before yielding to a thread with a smaller
+   pass. */
+#define STRIDE_SLICE 1
+
+/* Ready threads, smallest pass first. */
+static struct heap run_queue;
+
+/* Pass of the thread most recently scheduled. */
+static int64_t global_pass;
+
+static heap_less_func pass_less;
+
+/* Orders threads A and B by ascending pass.  Threads with equal
+   passes run in the order they became ready. */
+static bool
+pass_less (const struct heap_elem *a, const struct heap_elem *b,
+           void *aux UNUSED)
+{
+  return (heap_entry (a, struct thread, sched_elem)->pass
+          < heap_entry (b, struct thread, sched_elem)->pass);
+}
+
+static void
+stride_init (void)
+{
+  heap_init (&run_queue, pass_less, NULL);
+  global_pass = 0;
+}
+
+static void
+stride_enqueue (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (t->pass < global_pass)
+    t->pass = global_pass;
+  heap_insert (&run_queue, &t->sched_elem);
+}
+
+static struct thread *
+stride_pick_next (void)
+{
+  struct heap_elem *e;
+  struct thread *t;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  e = heap_pop (&run_queue);
+  if (e == NULL)
+    return NULL;
+  t = heap_entry (e, struct thread, sched_elem);
+  if (t->pass > global_pass)
+    global_pass = t->pass;
+  return t;
+}
+
+/* Newly ready threads wait for the end of the running thread's
+   slice, which is at most a tick away. */
+static bool
+stride_preempt (const struct thread *cur UNUSED)
+{
+  return false;
+}
+
+/* Charges the tick to CUR. */
+static bool
+stride_tick (struct thread *cur, unsigned slice_ticks)
+{
+  cur->pass += STRIDE1 / cur->tickets;
+  return slice_ticks >= STRIDE_SLICE && !heap_empty (&run_queue);
+}
+
+/* Priorities do not affect the order of the run queue. */
+static void
+stride_set_priority (struct thread *t, int priority)
+{
+  t->priority = priority;
+}
+
+/* Proportional-share scheduling by tickets. */
+const struct sched_class sched_stride_class =
+  {
+    .name = "stride",
+    .init = stride_init,
+    .enqueue = stride_enqueue,
+    .pick_next = stride_pick_next,
+    .preempt = stride_preempt,
+    .tick = stride_tick,
+    .set_priority = stride_set_priority,
+  };
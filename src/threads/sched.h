@@ -0,0 +1,65 @@
+#ifndef THREADS_SCHED_H
+#define THREADS_SCHED_H
+
+#include <stdbool.h>
+
+struct thread;
+
+/* A scheduling class: the policy that decides which ready thread
+   runs next, and for how long.
+
+   thread.c keeps track of thread states, the number of ready
+   threads, and how many ticks the running thread has had since
+   it was scheduled, and calls into the active class for
+   everything else.  The idle thread is never enqueued; it runs
+   whenever pick_next() returns a null pointer.  Every hook is
+   called with interrupts off. */
+struct sched_class
+  {
+    const char *name;           /* Name for "-sched=NAME". */
+
+    /* Initializes the class's run queue.  Called once, from
+       thread_init(). */
+    void (*init) (void);
+
+    /* Adds T, which is becoming ready, to the run queue. */
+    void (*enqueue) (struct thread *t);
+
+    /* Removes and returns the thread to run next, or returns a
+       null pointer if no thread is ready. */
+    struct thread *(*pick_next) (void);
+
+    /* Returns true if some ready thread should replace CUR, the
+       running thread, right away rather than at the end of CUR's
+       time slice. */
+    bool (*preempt) (const struct thread *cur);
+
+    /* Called at each timer tick, in the timer interrupt, while
+       CUR runs.  SLICE_TICKS is the number of ticks CUR has run
+       since it was last scheduled, including this one.  Returns
+       true if CUR should yield. */
+    bool (*tick) (struct thread *cur, unsigned slice_ticks);
+
+    /* Sets T's effective priority to PRIORITY, repositioning T
+       in the run queue if it is ready and the class cares. */
+    void (*set_priority) (struct thread *t, int priority);
+  };
+
+extern const struct sched_class *sched_class;
+
+extern const struct sched_class sched_priority_class;
+extern const struct sched_class sched_mlfqs_class;
+extern const struct sched_class sched_stride_class;
+
+/* Earliest-deadline-first class for threads that have called
+   thread_set_deadline().  It is not selected with sched_select():
+   it holds only those threads, and runs them ahead of the active
+   class. */
+extern const struct sched_class sched_edf_class;
+
+bool sched_select (const char *name);
+
+bool sched_edf_reserve (int period, int budget);
+void sched_edf_release (int period, int budget);
+
+#endif /* threads/sched.h */
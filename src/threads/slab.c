@@ -0,0 +1,279 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Object caches, after Bonwick's slab allocator.
+
+   malloc() rounds every request up to a power of 2, so an object
+   a little over a power of 2 in size wastes nearly half its
+   block.  A cache instead hands out objects of one type from
+   "slabs", pages divided into slots of exactly the object's size
+   (rounded up for alignment), so such objects pack much more
+   tightly.
+
+   Each slab keeps its free slots on a free list of slot indexes
+   stored in its header, not in the free objects themselves.  A
+   cache created with a constructor calls it once on each object
+   when a slab is created, and objects keep their constructed
+   state across kmem_cache_free() and kmem_cache_alloc(), so
+   callers must return them to that state before freeing them.
+
+   A cache keeps its slabs on three lists, by whether none, some,
+   or all of their objects are in use, and allocates from partial
+   slabs first so that empty ones can be given back to the page
+   allocator.  It keeps one empty slab on hand, so that
+   allocating and freeing a single object does not get and free a
+   page every time. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Object alignment. */
+#define SLAB_ALIGN 8
+
+/* Marks the end of a slab's free list. */
+#define SLOT_NONE 0xffff
+
+/* An object cache. */
+struct kmem_cache
+  {
+    struct list_elem elem;      /* Element in all_caches. */
+    char name[16];              /* Name, for statistics. */
+    size_t obj_size;            /* Size of a slot, in bytes. */
+    size_t objs_per_slab;       /* Slots in a slab. */
+    size_t first_ofs;           /* Offset of first slot in slab. */
+    kmem_ctor *ctor;            /* Constructor, or null. */
+    struct lock lock;           /* Protects everything below. */
+    struct list partial;        /* Slabs with some objects in use. */
+    struct list full;           /* Slabs with all objects in use. */
+    struct list empty;          /* Slabs with no objects in use. */
+
+    /* Statistics. */
+    size_t slab_cnt;            /* Slabs. */
+    size_t in_use;              /* Objects in use. */
+    size_t peak_in_use;         /* Greatest value of IN_USE. */
+    unsigned long long alloc_cnt; /* Calls to kmem_cache_alloc(). */
+    unsigned long long slab_alloc_cnt; /* Slabs obtained. */
+  };
+
+/* Slab header, at the start of the slab's page. */
+struct slab
+  {
+    unsigned magic;             /* Always SLAB_MAGIC. */
+    struct kmem_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in one of cache's lists. */
+    size_t in_use;              /* Objects in use. */
+    uint16_t free;              /* First free slot, or SLOT_NONE. */
+    uint16_t next[];            /* Slot after each free slot. */
+  };
+
+/* All caches, for statistics. */
+static struct list all_caches = LIST_INITIALIZER (all_caches);
+
+/* Creates and returns a cache of objects of SIZE bytes, named
+   NAME for statistics.  If CTOR is nonnull, it is called on each
+   object when the object's slab is created.  Panics if out of
+   memory, since caches are created at initialization time. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, kmem_ctor *ctor)
+{
+  struct kmem_cache *c;
+
+  ASSERT (size > 0);
+  size = ROUND_UP (size, SLAB_ALIGN);
+
+  c = malloc (sizeof *c);
+  if (c == NULL)
+    PANIC ("out of memory creating %s cache", name);
+  strlcpy (c->name, name, sizeof c->name);
+  c->obj_size = size;
+  c->ctor = ctor;
+
+  /* Each slot needs SIZE bytes plus an entry in the header's
+     NEXT array.  The division may overestimate by one once the
+     slots are aligned, so check. */
+  c->objs_per_slab = ((PGSIZE - sizeof (struct slab))
+                      / (size + sizeof (uint16_t)));
+  for (;;)
+    {
+      c->first_ofs = ROUND_UP (sizeof (struct slab)
+                               + c->objs_per_slab * sizeof (uint16_t),
+                               SLAB_ALIGN);
+      if (c->first_ofs + c->objs_per_slab * size <= PGSIZE)
+        break;
+      c->objs_per_slab--;
+    }
+  ASSERT (c->objs_per_slab > 0);
+
+  lock_init (&c->lock);
+  list_init (&c->partial);
+  list_init (&c->full);
+  list_init (&c->empty);
+  c->slab_cnt = c->in_use = c->peak_in_use = 0;
+  c->alloc_cnt = c->slab_alloc_cnt = 0;
+  list_push_back (&all_caches, &c->elem);
+  return c;
+}
+
+/* Returns the object in slot IDX of slab S. */
+static void *
+slot_to_obj (struct slab *s, size_t idx)
+{
+  return (uint8_t *) s + s->cache->first_ofs + idx * s->cache->obj_size;
+}
+
+/* Returns the slab that OBJ is in, which must belong to cache
+   C. */
+static struct slab *
+obj_to_slab (struct kmem_cache *c, void *obj)
+{
+  struct slab *s = pg_round_down (obj);
+
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == c);
+  ASSERT ((pg_ofs (obj) - c->first_ofs) % c->obj_size == 0);
+  return s;
+}
+
+/* Creates a new, empty slab for C and adds it to C's empty
+   list.  Returns false if out of memory.  C's lock must be
+   held. */
+static bool
+new_slab (struct kmem_cache *c)
+{
+  struct slab *s = palloc_get_page (0);
+  size_t i;
+
+  if (s == NULL)
+    return false;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->in_use = 0;
+  s->free = 0;
+  for (i = 0; i < c->objs_per_slab; i++)
+    {
+      s->next[i] = i + 1 < c->objs_per_slab ? i + 1 : SLOT_NONE;
+      if (c->ctor != NULL)
+        c->ctor (slot_to_obj (s, i));
+    }
+  list_push_back (&c->empty, &s->elem);
+  c->slab_cnt++;
+  c->slab_alloc_cnt++;
+  return true;
+}
+
+/* Allocates and returns an object from cache C, or a null
+   pointer if out of memory. */
+void *
+kmem_cache_alloc (struct kmem_cache *c)
+{
+  struct slab *s;
+  size_t idx;
+
+  lock_acquire (&c->lock);
+  if (list_empty (&c->partial))
+    {
+      if (list_empty (&c->empty) && !new_slab (c))
+        {
+          lock_release (&c->lock);
+          return NULL;
+        }
+      list_push_back (&c->partial, list_pop_front (&c->empty));
+    }
+  s = list_entry (list_front (&c->partial), struct slab, elem);
+
+  idx = s->free;
+  ASSERT (idx != SLOT_NONE);
+  s->free = s->next[idx];
+  if (++s->in_use == c->objs_per_slab)
+    {
+      list_remove (&s->elem);
+      list_push_back (&c->full, &s->elem);
+    }
+
+  c->alloc_cnt++;
+  if (++c->in_use > c->peak_in_use)
+    c->peak_in_use = c->in_use;
+  lock_release (&c->lock);
+
+  return slot_to_obj (s, idx);
+}
+
+/* Returns OBJ, which must have been allocated from cache C, to
+   C.  If C has a constructor, OBJ must be in its constructed
+   state. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj)
+{
+  struct slab *s;
+  size_t idx;
+
+  if (obj == NULL)
+    return;
+
+  s = obj_to_slab (c, obj);
+  idx = (pg_ofs (obj) - c->first_ofs) / c->obj_size;
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs, unless
+     that would destroy its constructed state. */
+  if (c->ctor == NULL)
+    memset (obj, 0xcc, c->obj_size);
+#endif
+
+  lock_acquire (&c->lock);
+  ASSERT (s->in_use > 0);
+  s->next[idx] = s->free;
+  s->free = idx;
+  if (s->in_use-- == c->objs_per_slab)
+    {
+      /* Was full, now partial. */
+      list_remove (&s->elem);
+      list_push_front (&c->partial, &s->elem);
+    }
+  if (s->in_use == 0)
+    {
+      /* Now empty.  Keep it if it is our only empty slab. */
+      list_remove (&s->elem);
+      if (list_empty (&c->empty))
+        list_push_back (&c->empty, &s->elem);
+      else
+        {
+          s->magic = 0;
+          palloc_free_page (s);
+          c->slab_cnt--;
+        }
+    }
+  c->in_use--;
+  lock_release (&c->lock);
+}
+
+/* Prints statistics for each cache. */
+void
+kmem_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_caches); e != list_end (&all_caches);
+       e = list_next (e))
+    {
+      struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+      size_t capacity = c->slab_cnt * c->objs_per_slab;
+
+      printf ("Slab: %s: %zu-byte objects, %zu per slab, "
+              "%zu of %zu in use (peak %zu) in %zu slabs, "
+              "%llu allocations, %llu slabs obtained\n",
+              c->name, c->obj_size, c->objs_per_slab,
+              c->in_use, capacity, c->peak_in_use, c->slab_cnt,
+              c->alloc_cnt, c->slab_alloc_cnt);
+    }
+}
@@ -29,8 +29,164 @@
 #include "threads/synch.h"
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "devices/timer.h"
+
+static heap_less_func sema_waiter_less;
+static heap_less_func cond_waiter_less;
+
+#ifdef LOCK_PROFILE
+/* Named contention profiles, in the order they were named. */
+static struct list profile_list = LIST_INITIALIZER (profile_list);
+
+/* Records that a down of SEMA is about to wait, and returns the
+   time at which the wait began. */
+static inline uint64_t
+profile_wait_begin (struct semaphore *sema)
+{
+	sema->profile.contended++;
+	return rdtsc ();
+}
+
+/* Records in P an acquisition that completed after waiting
+   since WAIT_START, or without waiting if WAIT_START is 0. */
+static void
+profile_note_acquire (struct lock_profile *p, uint64_t wait_start)
+{
+	p->acquired++;
+	if (wait_start != 0)
+	{
+		uint64_t wait = rdtsc () - wait_start;
+		p->wait_cycles += wait;
+		if (wait > p->max_wait_cycles)
+			p->max_wait_cycles = wait;
+	}
+}
+
+/* Records in P a hold that began at HOLD_START and ends now. */
+static void
+profile_note_release (struct lock_profile *p, uint64_t hold_start)
+{
+	uint64_t hold = rdtsc () - hold_start;
+
+	p->hold_cycles += hold;
+	if (hold > p->max_hold_cycles)
+		p->max_hold_cycles = hold;
+}
+
+/* Adds P to the list of named profiles under NAME. */
+static void
+profile_register (struct lock_profile *p, const char *name, bool is_lock)
+{
+	enum intr_level old_level;
+
+	ASSERT (name != NULL);
+	ASSERT (p->name == NULL);
+
+	old_level = intr_disable ();
+	p->name = name;
+	p->is_lock = is_lock;
+	list_push_back (&profile_list, &p->elem);
+	intr_set_level (old_level);
+}
+
+/* Records a down of SEMA that completed after waiting since
+   WAIT_START, or without waiting if WAIT_START is 0. */
+static inline void
+profile_acquired (struct semaphore *sema, uint64_t wait_start)
+{
+	profile_note_acquire (&sema->profile, wait_start);
+}
+
+/* Records that LOCK has just been acquired. */
+static inline void
+profile_hold_begin (struct lock *lock)
+{
+	lock->acquire_time = rdtsc ();
+}
+
+/* Records that LOCK is about to be released. */
+static inline void
+profile_hold_end (struct lock *lock)
+{
+	profile_note_release (&lock->semaphore.profile, lock->acquire_time);
+}
+
+/* Records that an acquisition of RW is about to wait, and
+   returns the time at which the wait began. */
+static inline uint64_t
+rw_profile_wait_begin (struct rwlock *rw)
+{
+	rw->profile.contended++;
+	return rdtsc ();
+}
+
+/* Records an acquisition of RW that completed after waiting
+   since WAIT_START, or without waiting if WAIT_START is 0. */
+static inline void
+rw_profile_acquired (struct rwlock *rw, uint64_t wait_start)
+{
+	profile_note_acquire (&rw->profile, wait_start);
+}
+
+/* Records that RW has just been acquired for writing. */
+static inline void
+rw_profile_write_begin (struct rwlock *rw)
+{
+	rw->write_time = rdtsc ();
+}
+
+/* Records that write access to RW is about to be given up. */
+static inline void
+rw_profile_write_end (struct rwlock *rw)
+{
+	profile_note_release (&rw->profile, rw->write_time);
+}
+#else
+static inline uint64_t
+profile_wait_begin (struct semaphore *sema UNUSED)
+{
+	return 0;
+}
+
+static inline void
+profile_acquired (struct semaphore *sema UNUSED, uint64_t wait_start UNUSED)
+{
+}
+
+static inline void
+profile_hold_begin (struct lock *lock UNUSED)
+{
+}
+
+static inline void
+profile_hold_end (struct lock *lock UNUSED)
+{
+}
+
+static inline uint64_t
+rw_profile_wait_begin (struct rwlock *rw UNUSED)
+{
+	return 0;
+}
+
+static inline void
+rw_profile_acquired (struct rwlock *rw UNUSED, uint64_t wait_start UNUSED)
+{
+}
+
+static inline void
+rw_profile_write_begin (struct rwlock *rw UNUSED)
+{
+}
+
+static inline void
+rw_profile_write_end (struct rwlock *rw UNUSED)
+{
+}
+#endif /* LOCK_PROFILE */
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -47,7 +203,32 @@ sema_init (struct semaphore *sema, unsigned value)
 	ASSERT (sema != NULL);
 
 	sema->value = value;
-	list_init (&sema->waiters);
+	heap_init (&sema->waiters, sema_waiter_less, NULL);
+#ifdef LOCK_PROFILE
+	memset (&sema->profile, 0, sizeof sema->profile);
+#endif
+}
+
+/* Names SEMA for lock_profile_print().  SEMA must never be
+   destroyed, since its profile stays on the list of named
+   profiles.  Does nothing unless LOCK_PROFILE is defined. */
+void
+sema_set_name (struct semaphore *sema UNUSED, const char *name UNUSED)
+{
+#ifdef LOCK_PROFILE
+	ASSERT (sema != NULL);
+
+	profile_register (&sema->profile, name, false);
+#endif
+}
+
+/* Orders semaphore waiters A and B by descending priority. */
+static bool
+sema_waiter_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED)
+{
+	return heap_entry (a, struct thread, wait_elem)->priority
+		> heap_entry (b, struct thread, wait_elem)->priority;
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -61,20 +242,117 @@ void
 sema_down (struct semaphore *sema) 
 {
 	enum intr_level old_level;
+	uint64_t wait_start = 0;
 
 	ASSERT (sema != NULL);
 	ASSERT (!intr_context ());
 
 	old_level = intr_disable ();
+	if (sema->value == 0)
+		wait_start = profile_wait_begin (sema);
 	while (sema->value == 0)
 	{
-		list_push_back (&sema->waiters, &thread_current ()->elem);
+		struct thread *cur = thread_current ();
+
+		/* Let a priority donation re-sift our place in the heap,
+		   unless cond_wait() already registered the heap that
+		   matters. */
+		heap_insert (&sema->waiters, &cur->wait_elem);
+		if (cur->wait_heap == NULL)
+		{
+			cur->wait_heap = &sema->waiters;
+			cur->wait_node = &cur->wait_elem;
+		}
 		thread_block ();
 	}
 	sema->value--;
+	profile_acquired (sema, wait_start);
 	intr_set_level (old_level);
 }
 
+/* A deadline on a thread's wait in sema_down_timeout(). */
+struct sema_timer
+{
+	struct timer_event event;           /* Fires at the deadline. */
+	struct semaphore *sema;             /* Semaphore waited on. */
+	struct thread *thread;              /* Waiting thread. */
+	bool expired;                       /* Has the deadline passed? */
+};
+
+/* Timer event for a sema_down_timeout() deadline.  If the thread
+   is still waiting, takes it off the semaphore's waiters and
+   wakes it up empty-handed.  A thread that sema_up() has already
+   woken is left alone. */
+static void
+sema_timer_expire (struct timer_event *e)
+{
+	struct sema_timer *st = (struct sema_timer *) e;
+	struct thread *t = st->thread;
+
+	st->expired = true;
+	if (t->status == THREAD_BLOCKED)
+	{
+		heap_remove (&st->sema->waiters, &t->wait_elem);
+		if (t->wait_heap == &st->sema->waiters)
+			t->wait_heap = NULL;
+		thread_unblock (t);
+	}
+}
+
+/* Down or "P" operation on a semaphore, giving up after TICKS
+   timer ticks.  Returns true if the semaphore was downed, false
+   if the time ran out first.  A TICKS of 0 or less does not wait
+   at all, like sema_try_down().
+
+   Like sema_down(), this function may sleep and must not be
+   called within an interrupt handler.  It may be called with
+   interrupts disabled, and returns with interrupts as they
+   were. */
+bool
+sema_down_timeout (struct semaphore *sema, int64_t ticks)
+{
+	struct sema_timer st;
+	enum intr_level old_level;
+	uint64_t wait_start = 0;
+	bool success;
+
+	ASSERT (sema != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	if (sema->value == 0 && ticks > 0)
+	{
+		wait_start = profile_wait_begin (sema);
+		st.sema = sema;
+		st.thread = thread_current ();
+		st.expired = false;
+		timer_event_init (&st.event, sema_timer_expire);
+		timer_event_add (&st.event, timer_ticks () + ticks);
+		while (sema->value == 0 && !st.expired)
+		{
+			struct thread *cur = thread_current ();
+
+			heap_insert (&sema->waiters, &cur->wait_elem);
+			if (cur->wait_heap == NULL)
+			{
+				cur->wait_heap = &sema->waiters;
+				cur->wait_node = &cur->wait_elem;
+			}
+			thread_block ();
+		}
+		timer_event_cancel (&st.event);
+	}
+	success = sema->value > 0;
+	if (success)
+	{
+		sema->value--;
+		profile_acquired (sema, wait_start);
+	}
+	intr_set_level (old_level);
+
+	return success;
+}
+
 /* Down or "P" operation on a semaphore, but only if the
    semaphore is not already 0.  Returns true if the semaphore is
    decremented, false otherwise.
@@ -92,6 +370,7 @@ sema_try_down (struct semaphore *sema)
 	if (sema->value > 0)
 	{
 		sema->value--;
+		profile_acquired (sema, 0);
 		success = true;
 	}
 	else
@@ -102,7 +381,8 @@ sema_try_down (struct semaphore *sema)
 }
 
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
-   and wakes up one thread of those waiting for SEMA, if any.
+   and wakes up the highest-priority thread of those waiting for
+   SEMA, if any, yielding to it if it outranks the caller.
 
    This function may be called from an interrupt handler. */
 void
@@ -113,11 +393,20 @@ sema_up (struct semaphore *sema)
 	ASSERT (sema != NULL);
 
 	old_level = intr_disable ();
-	if (!list_empty (&sema->waiters))
-		thread_unblock (list_entry (list_pop_front (&sema->waiters),
-				struct thread, elem));
+	if (!heap_empty (&sema->waiters))
+	{
+		/* The heap is stable, so among equals this is the waiter
+		   that has waited longest. */
+		struct thread *t = heap_entry (heap_pop (&sema->waiters),
+				struct thread, wait_elem);
+		if (t->wait_heap == &sema->waiters)
+			t->wait_heap = NULL;
+		thread_unblock (t);
+	}
 	sema->value++;
 	intr_set_level (old_level);
+
+	thread_check_preempt ();
 }
 
 static void sema_test_helper (void *sema_);
@@ -181,10 +470,26 @@ lock_init (struct lock *lock)
 	sema_init (&lock->semaphore, 1);
 }
 
+/* Names LOCK for lock_profile_print().  LOCK must never be
+   destroyed.  Does nothing unless LOCK_PROFILE is defined. */
+void
+lock_set_name (struct lock *lock UNUSED, const char *name UNUSED)
+{
+#ifdef LOCK_PROFILE
+	ASSERT (lock != NULL);
+
+	profile_register (&lock->semaphore.profile, name, true);
+#endif
+}
+
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
    thread.
 
+   While waiting, the current thread donates its priority to the
+   lock's holder, and transitively to the holders of any locks
+   that thread is waiting for (see thread_donate_priority()).
+
    This function may sleep, so it must not be called within an
    interrupt handler.  This function may be called with
    interrupts disabled, but interrupts will be turned back on if
@@ -192,13 +497,25 @@ lock_init (struct lock *lock)
 void
 lock_acquire (struct lock *lock)
 {
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (!lock_held_by_current_thread (lock));
 
+	old_level = intr_disable ();
+	if (lock->holder != NULL && !thread_mlfqs)
+	{
+		cur->waiting_lock = lock;
+		thread_donate_priority (cur);
+	}
 	sema_down (&lock->semaphore);
-	lock->holder = thread_current ();
-	list_push_back(&thread_current()->lock_list, &lock->elem);
+	cur->waiting_lock = NULL;
+	lock->holder = cur;
+	list_push_back(&cur->lock_list, &lock->elem);
+	profile_hold_begin (lock);
+	intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -219,11 +536,14 @@ lock_try_acquire (struct lock *lock)
 	if (success){
 		lock->holder = thread_current ();
 		list_push_back(&thread_current()->lock_list, &lock->elem);
+		profile_hold_begin (lock);
 	}
 	return success;
 }
 
 /* Releases LOCK, which must be owned by the current thread.
+   Gives up any priority donated through LOCK; priority donated
+   through other locks that the thread still holds is kept.
 
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to release a lock within an interrupt
@@ -231,12 +551,62 @@ lock_try_acquire (struct lock *lock)
 void
 lock_release (struct lock *lock) 
 {
+	enum intr_level old_level;
+
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
+	old_level = intr_disable ();
+	profile_hold_end (lock);
 	lock->holder = NULL;
 	list_remove(&lock->elem);
+	if (!thread_mlfqs)
+		thread_update_priority (thread_current ());
 	sema_up (&lock->semaphore);
+	intr_set_level (old_level);
+}
+
+/* Acquires LOCK like lock_acquire(), but gives up after TICKS
+   timer ticks.  Returns true if LOCK was acquired, false if the
+   time ran out first, in which case any priority that the
+   current thread donated while it waited is taken back.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+bool
+lock_acquire_timeout (struct lock *lock, int64_t ticks)
+{
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	bool success;
+
+	ASSERT (lock != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (!lock_held_by_current_thread (lock));
+
+	old_level = intr_disable ();
+	if (lock->holder != NULL && !thread_mlfqs)
+	{
+		cur->waiting_lock = lock;
+		thread_donate_priority (cur);
+	}
+	success = sema_down_timeout (&lock->semaphore, ticks);
+	cur->waiting_lock = NULL;
+	if (success)
+	{
+		lock->holder = cur;
+		list_push_back(&cur->lock_list, &lock->elem);
+		profile_hold_begin (lock);
+	}
+	else if (!thread_mlfqs)
+	{
+		/* Recompute the priorities along the chain of holders
+		   that we donated to, now that we are not waiting. */
+		thread_update_priority_chain (lock->holder);
+	}
+	intr_set_level (old_level);
+
+	return success;
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -250,13 +620,24 @@ lock_held_by_current_thread (const struct lock *lock)
 	return lock->holder == thread_current ();
 }
 
-/* One semaphore in a list. */
+/* One semaphore in a condition variable's wait heap. */
 struct semaphore_elem 
 {
-	struct list_elem elem;              /* List element. */
+	struct heap_elem elem;              /* Heap element. */
+	struct thread *thread;              /* Waiting thread. */
 	struct semaphore semaphore;         /* This semaphore. */
 };
 
+/* Orders condition variable waiters A and B by descending
+   priority of the waiting threads. */
+static bool
+cond_waiter_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED)
+{
+	return heap_entry (a, struct semaphore_elem, elem)->thread->priority
+		> heap_entry (b, struct semaphore_elem, elem)->thread->priority;
+}
+
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
@@ -265,7 +646,7 @@ cond_init (struct condition *cond)
 {
 	ASSERT (cond != NULL);
 
-	list_init (&cond->waiters);
+	heap_init (&cond->waiters, cond_waiter_less, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -292,22 +673,76 @@ void
 cond_wait (struct condition *cond, struct lock *lock) 
 {
 	struct semaphore_elem waiter;
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
 
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
+	/* The heap is re-sifted from change_priority() with
+	   interrupts off, so it is only touched with interrupts off,
+	   not merely under LOCK. */
 	sema_init (&waiter.semaphore, 0);
-	list_push_back (&cond->waiters, &waiter.elem);
+	waiter.thread = cur;
+	old_level = intr_disable ();
+	heap_insert (&cond->waiters, &waiter.elem);
+	cur->wait_heap = &cond->waiters;
+	cur->wait_node = &waiter.elem;
+	intr_set_level (old_level);
 	lock_release (lock);
 	sema_down (&waiter.semaphore);
 	lock_acquire (lock);
 }
 
+/* Like cond_wait(), but gives up waiting for a signal after
+   TICKS timer ticks.  Returns true if COND was signaled, false if
+   the time ran out first.  Either way, LOCK is held again on
+   return.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+bool
+cond_wait_timeout (struct condition *cond, struct lock *lock, int64_t ticks)
+{
+	struct semaphore_elem waiter;
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	bool signaled;
+
+	ASSERT (cond != NULL);
+	ASSERT (lock != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (lock_held_by_current_thread (lock));
+
+	/* Interrupts stay off from joining the waiters until we know
+	   whether we were signaled, so that a signal cannot slip in
+	   between the time running out and our leaving the heap. */
+	sema_init (&waiter.semaphore, 0);
+	waiter.thread = cur;
+	old_level = intr_disable ();
+	heap_insert (&cond->waiters, &waiter.elem);
+	cur->wait_heap = &cond->waiters;
+	cur->wait_node = &waiter.elem;
+	lock_release (lock);
+	signaled = sema_down_timeout (&waiter.semaphore, ticks);
+	if (!signaled)
+	{
+		heap_remove (&cond->waiters, &waiter.elem);
+		if (cur->wait_heap == &cond->waiters)
+			cur->wait_heap = NULL;
+	}
+	intr_set_level (old_level);
+	lock_acquire (lock);
+
+	return signaled;
+}
+
 /* If any threads are waiting on COND (protected by LOCK), then
-   this function signals one of them to wake up from its wait.
-   LOCK must be held before calling this function.
+   this function signals the highest-priority one of them to wake
+   up from its wait.  LOCK must be held before calling this
+   function.
 
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to signal a condition variable within an
@@ -315,14 +750,23 @@ cond_wait (struct condition *cond, struct lock *lock)
 void
 cond_signal (struct condition *cond, struct lock *lock UNUSED) 
 {
+	enum intr_level old_level;
+
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters))
-		sema_up (&list_entry (list_pop_front (&cond->waiters),
-				struct semaphore_elem, elem)->semaphore);
+	old_level = intr_disable ();
+	if (!heap_empty (&cond->waiters))
+	{
+		struct semaphore_elem *waiter = heap_entry (heap_pop (&cond->waiters),
+				struct semaphore_elem, elem);
+		if (waiter->thread->wait_heap == &cond->waiters)
+			waiter->thread->wait_heap = NULL;
+		sema_up (&waiter->semaphore);
+	}
+	intr_set_level (old_level);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -337,6 +781,359 @@ cond_broadcast (struct condition *cond, struct lock *lock)
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 
-	while (!list_empty (&cond->waiters))
+	while (!heap_empty (&cond->waiters))
 		cond_signal (cond, lock);
-}
\ No newline at end of file
+}
+
+/* Initializes reader-writer lock RW.  Any number of threads may
+   hold RW for reading at once, or a single thread may hold it
+   for writing.
+
+   RW prefers writers: a thread that wants to read waits while
+   a writer of the same or higher priority is waiting, so a
+   steady stream of readers cannot starve writers.  It is also
+   priority-aware: a reader of strictly higher priority than
+   every waiting writer is still admitted, and when RW becomes
+   free it goes to the highest-priority waiters first. */
+void
+rw_init (struct rwlock *rw)
+{
+	ASSERT (rw != NULL);
+
+	rw->readers = 0;
+	rw->writer = NULL;
+	rw->upgrader = NULL;
+	list_init (&rw->read_waiters);
+	list_init (&rw->write_waiters);
+#ifdef LOCK_PROFILE
+	memset (&rw->profile, 0, sizeof rw->profile);
+#endif
+}
+
+/* Names RW for lock_profile_print().  RW must never be
+   destroyed.  Hold times are recorded for write access only.
+   Does nothing unless LOCK_PROFILE is defined. */
+void
+rw_set_name (struct rwlock *rw UNUSED, const char *name UNUSED)
+{
+#ifdef LOCK_PROFILE
+	ASSERT (rw != NULL);
+
+	profile_register (&rw->profile, name, true);
+#endif
+}
+
+/* Returns the priority of the highest-priority thread waiting
+   for write access to RW, or -1 if there is none. */
+static int
+rw_max_writer_priority (struct rwlock *rw)
+{
+	if (list_empty (&rw->write_waiters))
+		return -1;
+	return list_entry (list_min (&rw->write_waiters,
+			thread_priority_comparator, NULL), struct thread, elem)->priority;
+}
+
+/* Donates the current thread's priority to the thread holding
+   RW for writing, if any, since the current thread is about to
+   wait for it.  Readers are not tracked, so a thread that waits
+   only for readers to leave donates nothing.  Interrupts must be
+   off. */
+static void
+rw_donate (struct rwlock *rw)
+{
+	struct thread *cur = thread_current ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (rw->writer != NULL && !thread_mlfqs)
+	{
+		cur->waiting_rwlock = rw;
+		thread_donate_priority (cur);
+	}
+}
+
+/* Gives up the current thread's write access to RW, along with
+   any priority donated through it.  Interrupts must be off. */
+static void
+rw_give_up_write (struct rwlock *rw)
+{
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	rw->writer = NULL;
+	list_remove (&rw->elem);
+	if (!thread_mlfqs)
+		thread_update_priority (thread_current ());
+}
+
+/* Wakes the threads that should get RW next, now that some
+   access to it has been given up.  Woken threads recheck their
+   conditions when they run.  Interrupts must be off. */
+static void
+rw_wake (struct rwlock *rw)
+{
+	int writer_priority = rw_max_writer_priority (rw);
+	bool woke_reader = false;
+	struct list_elem *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	/* A pending upgrade goes first, once its caller is the only
+	   reader left. */
+	if (rw->upgrader != NULL)
+	{
+		if (rw->readers == 1 && rw->upgrader->status == THREAD_BLOCKED)
+			thread_unblock (rw->upgrader);
+		return;
+	}
+	if (rw->writer != NULL)
+		return;
+
+	/* Admit every waiting reader that outranks all waiting
+	   writers. */
+	for (e = list_begin (&rw->read_waiters); e != list_end (&rw->read_waiters);)
+	{
+		struct thread *t = list_entry (e, struct thread, elem);
+
+		e = list_next (e);
+		if (t->priority > writer_priority)
+		{
+			list_remove (&t->elem);
+			thread_unblock (t);
+			woke_reader = true;
+		}
+	}
+
+	/* Otherwise hand RW to the highest-priority writer. */
+	if (!woke_reader && rw->readers == 0 && writer_priority >= 0)
+	{
+		struct list_elem *w = list_min (&rw->write_waiters,
+				thread_priority_comparator, NULL);
+		list_remove (w);
+		thread_unblock (list_entry (w, struct thread, elem));
+	}
+}
+
+/* Acquires RW for reading, sleeping until no thread holds it
+   for writing and no writer of the same or higher priority is
+   waiting for it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rw_read_acquire (struct rwlock *rw)
+{
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	uint64_t wait_start = 0;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (rw->writer != cur);
+
+	old_level = intr_disable ();
+	while (rw->writer != NULL || rw->upgrader != NULL
+			|| rw_max_writer_priority (rw) >= cur->priority)
+	{
+		if (wait_start == 0)
+			wait_start = rw_profile_wait_begin (rw);
+		list_push_back (&rw->read_waiters, &cur->elem);
+		rw_donate (rw);
+		thread_block ();
+	}
+	cur->waiting_rwlock = NULL;
+	rw->readers++;
+	rw_profile_acquired (rw, wait_start);
+	intr_set_level (old_level);
+}
+
+/* Releases read access to RW, which the current thread must
+   hold. */
+void
+rw_read_release (struct rwlock *rw)
+{
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (rw->readers > 0);
+
+	old_level = intr_disable ();
+	rw->readers--;
+	rw_wake (rw);
+	intr_set_level (old_level);
+
+	thread_check_preempt ();
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it at all.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rw_write_acquire (struct rwlock *rw)
+{
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	uint64_t wait_start = 0;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (rw->writer != cur);
+
+	old_level = intr_disable ();
+	while (rw->writer != NULL || rw->readers > 0 || rw->upgrader != NULL)
+	{
+		if (wait_start == 0)
+			wait_start = rw_profile_wait_begin (rw);
+		list_push_back (&rw->write_waiters, &cur->elem);
+		rw_donate (rw);
+		thread_block ();
+	}
+	cur->waiting_rwlock = NULL;
+	rw->writer = cur;
+	list_push_back (&cur->rwlock_list, &rw->elem);
+	rw_profile_acquired (rw, wait_start);
+	rw_profile_write_begin (rw);
+	intr_set_level (old_level);
+}
+
+/* Releases write access to RW, which the current thread must
+   hold. */
+void
+rw_write_release (struct rwlock *rw)
+{
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (rw_held_for_write_by_current_thread (rw));
+
+	old_level = intr_disable ();
+	rw_profile_write_end (rw);
+	rw_give_up_write (rw);
+	rw_wake (rw);
+	intr_set_level (old_level);
+
+	thread_check_preempt ();
+}
+
+/* Converts the current thread's read access to RW into write
+   access, waiting for the other readers to leave.  Returns true
+   if successful.  Only one upgrade may be pending at a time,
+   because two readers waiting for each other to leave would
+   deadlock; if another thread is already upgrading, returns
+   false at once, and the caller still holds read access.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+bool
+rw_upgrade (struct rwlock *rw)
+{
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (rw->readers > 0);
+
+	old_level = intr_disable ();
+	if (rw->upgrader != NULL)
+	{
+		intr_set_level (old_level);
+		return false;
+	}
+	rw->upgrader = cur;
+	while (rw->readers > 1)
+		thread_block ();
+	rw->upgrader = NULL;
+	rw->readers = 0;
+	rw->writer = cur;
+	list_push_back (&cur->rwlock_list, &rw->elem);
+	rw_profile_write_begin (rw);
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Converts the current thread's write access to RW into read
+   access, letting in any waiting readers that are allowed to
+   read alongside it.  Never sleeps. */
+void
+rw_downgrade (struct rwlock *rw)
+{
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (rw_held_for_write_by_current_thread (rw));
+
+	old_level = intr_disable ();
+	rw_profile_write_end (rw);
+	rw_give_up_write (rw);
+	rw->readers = 1;
+	rw_wake (rw);
+	intr_set_level (old_level);
+
+	thread_check_preempt ();
+}
+
+/* Returns true if the current thread holds RW for writing,
+   false otherwise. */
+bool
+rw_held_for_write_by_current_thread (const struct rwlock *rw)
+{
+	ASSERT (rw != NULL);
+
+	return rw->writer == thread_current ();
+}
+
+/* Prints the contention profile of every named semaphore and
+   lock.  May be called at any time; prints nothing unless
+   LOCK_PROFILE is defined. */
+void
+lock_profile_print (void)
+{
+#ifdef LOCK_PROFILE
+	enum intr_level old_level;
+	struct list_elem *e;
+
+	old_level = intr_disable ();
+	for (e = list_begin (&profile_list); e != list_end (&profile_list);
+			e = list_next (e))
+	{
+		struct lock_profile *p = list_entry (e, struct lock_profile, elem);
+
+		printf ("Lock profile: %s: %u acquired, %u contended, "
+				"%llu wait cycles (max %llu)",
+				p->name, p->acquired, p->contended,
+				p->wait_cycles, p->max_wait_cycles);
+		if (p->is_lock)
+			printf (", %llu hold cycles (max %llu)",
+					p->hold_cycles, p->max_hold_cycles);
+		printf ("\n");
+	}
+	intr_set_level (old_level);
+#endif
+}
+
+/* Clears the counters of every named semaphore and lock, for
+   example to profile one phase of a workload.  Does nothing
+   unless LOCK_PROFILE is defined. */
+void
+lock_profile_reset (void)
+{
+#ifdef LOCK_PROFILE
+	enum intr_level old_level;
+	struct list_elem *e;
+
+	old_level = intr_disable ();
+	for (e = list_begin (&profile_list); e != list_end (&profile_list);
+			e = list_next (e))
+	{
+		struct lock_profile *p = list_entry (e, struct lock_profile, elem);
+
+		p->acquired = p->contended = 0;
+		p->wait_cycles = p->max_wait_cycles = 0;
+		p->hold_cycles = p->max_hold_cycles = 0;
+	}
+	intr_set_level (old_level);
+#endif
+}
@@ -1,19 +1,53 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+/* Contention profile of a semaphore or lock.
+
+   Collected only if the kernel is built with LOCK_PROFILE
+   defined, e.g. by adding -DLOCK_PROFILE to DEFINES in
+   Make.vars.  Otherwise semaphores and locks carry no profile,
+   and the profiling calls below do nothing.
+
+   Every semaphore and lock keeps a profile, but only those given
+   a name with sema_set_name() or lock_set_name() are reported by
+   lock_profile_print().  Cycle counts come from the time-stamp
+   counter. */
+struct lock_profile
+  {
+    const char *name;           /* Name, or null if not reported. */
+    struct list_elem elem;      /* Element in list of named profiles. */
+    bool is_lock;               /* Part of a lock? */
+    unsigned acquired;          /* # of downs or acquisitions. */
+    unsigned contended;         /* # of those that had to wait. */
+    uint64_t wait_cycles;       /* Total cycles spent waiting. */
+    uint64_t max_wait_cycles;   /* Longest wait. */
+    uint64_t hold_cycles;       /* Total cycles held, for locks. */
+    uint64_t max_hold_cycles;   /* Longest hold, for locks. */
+  };
+
+void lock_profile_print (void);
+void lock_profile_reset (void);
 
 /* A counting semaphore. */
 struct semaphore 
   {
     unsigned value;             /* Current value. */
-    struct list waiters;        /* List of waiting threads. */
+    struct heap waiters;        /* Waiting threads, by priority. */
+#ifdef LOCK_PROFILE
+    struct lock_profile profile; /* Contention profile. */
+#endif
   };
 
 void sema_init (struct semaphore *, unsigned value);
+void sema_set_name (struct semaphore *, const char *name);
 void sema_down (struct semaphore *);
 bool sema_try_down (struct semaphore *);
+bool sema_down_timeout (struct semaphore *, int64_t ticks);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
 
@@ -23,25 +57,56 @@ struct lock
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
     struct list_elem elem;	    /* List to hold elements of lock_list */
+#ifdef LOCK_PROFILE
+    uint64_t acquire_time;      /* TSC when acquired. */
+#endif
   };
 
 void lock_init (struct lock *);
+void lock_set_name (struct lock *, const char *name);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
+bool lock_acquire_timeout (struct lock *, int64_t ticks);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
 /* Condition variable. */
 struct condition 
   {
-    struct list waiters;        /* List of waiting threads. */
+    struct heap waiters;        /* Waiting threads, by priority. */
   };
 
 void cond_init (struct condition *);
 void cond_wait (struct condition *, struct lock *);
+bool cond_wait_timeout (struct condition *, struct lock *, int64_t ticks);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock. */
+struct rwlock
+  {
+    unsigned readers;           /* # of threads holding read access. */
+    struct thread *writer;      /* Thread holding write access, if any. */
+    struct thread *upgrader;    /* Reader waiting in rw_upgrade(), if any. */
+    struct list read_waiters;   /* Threads waiting for read access. */
+    struct list write_waiters;  /* Threads waiting for write access. */
+    struct list_elem elem;      /* Element in writer's rwlock_list. */
+#ifdef LOCK_PROFILE
+    struct lock_profile profile; /* Contention profile. */
+    uint64_t write_time;        /* TSC when write access was taken. */
+#endif
+  };
+
+void rw_init (struct rwlock *);
+void rw_set_name (struct rwlock *, const char *name);
+void rw_read_acquire (struct rwlock *);
+void rw_read_release (struct rwlock *);
+void rw_write_acquire (struct rwlock *);
+void rw_write_release (struct rwlock *);
+bool rw_upgrade (struct rwlock *);
+void rw_downgrade (struct rwlock *);
+bool rw_held_for_write_by_current_thread (const struct rwlock *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
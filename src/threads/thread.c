@@ -4,14 +4,18 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/sched.h"
 #include "threads/switch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #ifdef USERPROG
+#include "userprog/fpu.h"
 #include "userprog/process.h"
 #include "userprog/syscall.h"
 /* Global shared buffer for IPC. */
@@ -23,22 +27,35 @@ struct ipc_buffer shared_ipc_buffer;
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-bool thread_alive = false;
-bool foreach_finished = false;
-
 static void release_locks (struct thread * t);
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Run queues of the priority and 4.4BSD scheduling classes,
+   holding processes in THREAD_READY state, that is, processes
+   that are ready to run but not actually running.
+   There is one FIFO queue per priority level.  Bit N of
+   ready_bitmap is set if and only if ready_queues[N] is
+   nonempty, so the highest-priority ready thread can be found
+   with a single bit scan instead of a walk over every ready
+   thread. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint32_t ready_bitmap[(PRI_MAX + 32) / 32];
+
+/* Number of threads in THREAD_READY state, whatever the
+   scheduling class. */
+static int ready_cnt;
+
+/* Active scheduling class.  Selected by kernel command-line
+   option "-sched=NAME", before thread_init(). */
+const struct sched_class *sched_class = &sched_priority_class;
+
+/* Scheduling classes that sched_select() knows about. */
+static const struct sched_class *const sched_classes[] =
+	{ &sched_priority_class, &sched_mlfqs_class, &sched_stride_class };
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
 static struct list all_list;
 
-/* Idle thread. */
-static struct thread *idle_thread;
-
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
@@ -53,20 +70,41 @@ struct kernel_thread_frame
 	void *aux;                  /* Auxiliary data for function. */
 };
 
-/* Statistics. */
-static long long idle_ticks;    /* # of timer ticks spent idle. */
-static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
-static long long user_ticks;    /* # of timer ticks in user programs. */
+/* Scheduler statistics.  LATENCY_HIST is the histogram of
+   wakeup-to-run latency described in <schedstat.h>, and
+   EXITED_STATS sums the counters of threads that have exited. */
+static unsigned latency_hist[SCHEDSTAT_BUCKETS];
+static struct schedstat exited_stats;
+
+/* Cache of pages freed by dying threads, reused by
+   thread_create() before falling back to palloc_get_page().
+   Only the struct thread at the bottom of a page is cleared
+   when it is reused: a thread's stack is never read before it
+   is written, so the rest of the page need not be zeroed at
+   all.  Accessed only with interrupts off. */
+#define THREAD_CACHE_SIZE 16    /* Max pages kept. */
+static struct thread *thread_cache[THREAD_CACHE_SIZE];
+static int thread_cache_cnt;    /* # of pages in thread_cache. */
+static unsigned thread_cache_hits;   /* # of thread_create()s served. */
+static unsigned thread_cache_misses; /* # sent to palloc_get_page(). */
 
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
 static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 
-/* If false (default), use round-robin scheduler.
-   If true, use multi-level feedback queue scheduler.
-   Controlled by kernel command-line option "-o mlfqs". */
+/* True if the active scheduling class is the multi-level
+   feedback queue scheduler.  Set by sched_select(). */
 bool thread_mlfqs;
 
+/* 4.4BSD scheduler.  Recomputing every thread's priority every
+   few ticks would make thread_tick() O(threads).  Between the
+   once-per-second decay of recent_cpu, only the running thread's
+   recent_cpu changes, so only its priority is recomputed every
+   MLFQS_PRI_TICKS ticks; all threads are updated once a
+   second. */
+#define MLFQS_PRI_TICKS 4       /* Ticks between priority updates. */
+static fixed_t load_avg;        /* System load average. */
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -75,9 +113,28 @@ static struct thread *next_thread_to_run (void);
 static void init_thread (struct thread *, const char *name, int priority);
 static bool is_thread (struct thread *) UNUSED;
 static void *alloc_frame (struct thread *, size_t size);
+static void ready_queue_push (struct thread *);
+static void ready_queue_remove (struct thread *);
+static void change_priority (struct thread *, int priority);
+static const struct sched_class *thread_sched_class (const struct thread *);
+static struct thread *ready_queue_pop (void);
+static int ready_queue_max_priority (void);
+static void ready_enqueue (struct thread *);
+static void ready_queue_init (void);
+static bool ready_queue_preempt (const struct thread *);
+static void ready_queue_set_priority (struct thread *, int priority);
+static bool priority_tick (struct thread *, unsigned slice_ticks);
+static bool mlfqs_tick (struct thread *, unsigned slice_ticks);
+static struct thread *thread_page_alloc (void);
+static void thread_page_free (struct thread *);
+static void print_thread_stats (struct thread *, void *aux);
+static void add_thread_stats (struct schedstat *, const struct thread *);
 static void schedule (void);
 void thread_schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
+static int mlfqs_priority (const struct thread *);
+static void mlfqs_update_priority (struct thread *);
+static void mlfqs_update_second (void);
 
 /* Initializes the threading system by transforming the code
    that's currently running into a thread.  This can't work in
@@ -98,12 +155,16 @@ thread_init (void)
 	ASSERT (intr_get_level () == INTR_OFF);
 
 	lock_init (&tid_lock);
-	list_init (&ready_list);
+	lock_set_name (&tid_lock, "tid");
+	sched_class->init ();
+	sched_edf_class.init ();
 	list_init (&all_list);
 
+#ifdef USERPROG
 	/* Initialize the shared IPC buffer and semaphore. */
 	sema_init(&shared_ipc_buffer.sema, 1); /* Semaphore starts as available */
 	memset(shared_ipc_buffer.data, 0, IPC_BUFFER_SIZE);
+#endif
 
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread ();
@@ -125,7 +186,7 @@ thread_start (void)
 	/* Start preemptive thread scheduling. */
 	intr_enable ();
 
-	/* Wait for the idle thread to initialize idle_thread. */
+	/* Wait for the idle thread to register itself with the CPU. */
 	sema_down (&idle_started);
 }
 
@@ -135,28 +196,110 @@ void
 thread_tick (void) 
 {
 	struct thread *t = thread_current ();
+	struct cpu *cpu = cpu_current ();
+	bool yield;
 
 	/* Update statistics. */
-	if (t == idle_thread)
-		idle_ticks++;
+	if (t == cpu->idle_thread)
+		cpu->idle_ticks++;
 #ifdef USERPROG
 	else if (t->pagedir != NULL)
-		user_ticks++;
+		cpu->user_ticks++;
 #endif
 	else
-		kernel_ticks++;
-
-	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+		cpu->kernel_ticks++;
+
+	/* Let the scheduling class update its state and enforce
+	   preemption.  The active class sees every tick, so that its
+	   global bookkeeping stays current, but has no say over EDF
+	   threads. */
+	yield = sched_class->tick (t, ++thread_ticks);
+	if (t->edf_period != 0)
+		yield = sched_edf_class.tick (t, thread_ticks);
+	if (yield)
 		intr_yield_on_return ();
 }
 
-/* Prints thread statistics. */
+/* Prints thread statistics: global tick counts, per-thread
+   scheduler counters for each live thread and for all exited
+   threads together, and the wakeup latency histogram. */
 void
 thread_print_stats (void) 
 {
+	struct cpu *cpu = cpu_current ();
+	enum intr_level old_level;
+	int i;
+
 	printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
-			idle_ticks, kernel_ticks, user_ticks);
+			cpu->idle_ticks, cpu->kernel_ticks, cpu->user_ticks);
+
+	old_level = intr_disable ();
+	thread_foreach (print_thread_stats, NULL);
+	printf ("Thread: exited threads: %llu run cycles, %llu wait cycles, "
+			"%u voluntary, %u involuntary switches\n",
+			exited_stats.run_cycles, exited_stats.wait_cycles,
+			exited_stats.voluntary_switches,
+			exited_stats.involuntary_switches);
+	printf ("Thread: page cache: %u hits, %u misses, %d cached\n",
+			thread_cache_hits, thread_cache_misses, thread_cache_cnt);
+	for (i = 0; i < SCHEDSTAT_BUCKETS; i++)
+		if (latency_hist[i] != 0)
+			printf ("Thread: wakeup latency %s%llu cycles: %u\n",
+					i == SCHEDSTAT_BUCKETS - 1 ? ">= " : "~",
+					i == 0 ? 0 : 1ULL << i, latency_hist[i]);
+	intr_set_level (old_level);
+}
+
+/* Prints the scheduler counters of thread T.
+   Used by thread_print_stats() via thread_foreach(). */
+static void
+print_thread_stats (struct thread *t, void *aux UNUSED)
+{
+	printf ("Thread: %d %s: %llu run cycles, %llu wait cycles, "
+			"%u voluntary, %u involuntary switches\n",
+			t->tid, t->name, t->run_cycles, t->wait_cycles,
+			t->voluntary_switches, t->involuntary_switches);
+}
+
+/* Adds T's scheduler counters to those in ST. */
+static void
+add_thread_stats (struct schedstat *st, const struct thread *t)
+{
+	st->run_cycles += t->run_cycles;
+	st->wait_cycles += t->wait_cycles;
+	st->voluntary_switches += t->voluntary_switches;
+	st->involuntary_switches += t->involuntary_switches;
+}
+
+/* Fills ST with the running thread's scheduler counters, up to
+   the present moment, and the system-wide wakeup latency
+   histogram. */
+void
+thread_get_schedstat (struct schedstat *st)
+{
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+	int i;
+
+	old_level = intr_disable ();
+	st->run_cycles = cur->run_cycles + (rdtsc () - cur->sched_stamp);
+	st->wait_cycles = cur->wait_cycles;
+	st->voluntary_switches = cur->voluntary_switches;
+	st->involuntary_switches = cur->involuntary_switches;
+	for (i = 0; i < SCHEDSTAT_BUCKETS; i++)
+		st->latency_hist[i] = latency_hist[i];
+	intr_set_level (old_level);
+}
+
+/* Returns the number of timer ticks spent in the idle thread
+   since boot. */
+long long
+thread_get_idle_ticks (void)
+{
+	enum intr_level old_level = intr_disable ();
+	long long t = cpu_current ()->idle_ticks;
+	intr_set_level (old_level);
+	return t;
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -188,7 +331,7 @@ thread_create (const char *name, int priority,
 	ASSERT (function != NULL);
 
 	/* Allocate thread. */
-	t = palloc_get_page (PAL_ZERO);
+	t = thread_page_alloc ();
 	if (t == NULL)
 		return TID_ERROR;
 
@@ -215,13 +358,15 @@ thread_create (const char *name, int priority,
 
 	intr_set_level (old_level);
 
+#ifdef USERPROG
 	/* Add child process to list */
 	t->parent = thread_tid();
-	add_child_process(t->tid, thread_current());
-	t->cp = get_child_process(t->tid, thread_current());
+	t->cp = add_child_process(t->tid, thread_current());
+#endif
 
 	/* Add to run queue. */
 	thread_unblock (t);
+	thread_check_preempt ();
 
 	return tid;
 }
@@ -260,14 +405,10 @@ thread_unblock (struct thread *t)
 	old_level = intr_disable ();
 	ASSERT (t->status == THREAD_BLOCKED);
 
-	/* Insert thread in the ready list based on priority (if MLFQS or priority scheduling is used). */
-    if (thread_mlfqs) {
-        list_insert_ordered(&ready_list, &t->elem, thread_priority_comparator, NULL);
-    } else {
-        list_push_back(&ready_list, &t->elem);
-    }
-
+	ready_enqueue (t);
 	t->status = THREAD_READY;
+	t->sched_stamp = rdtsc ();
+	t->woken = true;
 	intr_set_level (old_level);
 }
 
@@ -314,11 +455,15 @@ thread_exit (void)
 #ifdef USERPROG
 	process_exit ();
 #endif
+	malloc_thread_exit ();
 
 	/* Remove thread from all threads list, set our status to dying,
      and schedule another process.  That process will destroy us
      when it calls thread_schedule_tail(). */
 	intr_disable ();
+	if (thread_current ()->edf_period != 0)
+		sched_edf_release (thread_current ()->edf_period,
+				thread_current ()->edf_budget);
 	release_locks(thread_current());
 	list_remove (&thread_current()->allelem);
 	thread_current ()->status = THREAD_DYING;
@@ -337,8 +482,8 @@ thread_yield (void)
 	ASSERT (!intr_context ());
 
 	old_level = intr_disable ();
-	if (cur != idle_thread)
-		list_push_back (&ready_list, &cur->elem);
+	if (cur != cpu_current ()->idle_thread)
+		ready_enqueue (cur);
 	cur->status = THREAD_READY;
 	schedule ();
 	intr_set_level (old_level);
@@ -361,11 +506,152 @@ thread_foreach (thread_action_func *func, void *aux)
 	}
 }
 
-/* Sets the current thread's priority to NEW_PRIORITY. */
+/* Yields the CPU if the scheduling class says that some ready
+   thread should replace the running thread, for example because
+   it has a higher priority.  Within an external interrupt
+   handler, the yield is deferred until the interrupt returns. */
+void
+thread_check_preempt (void)
+{
+	struct thread *cur = thread_current ();
+	enum intr_level old_level = intr_disable ();
+	bool preempt = (sched_edf_class.preempt (cur)
+			|| (cur->edf_period == 0 && sched_class->preempt (cur)));
+	intr_set_level (old_level);
+
+	if (!preempt)
+		return;
+	if (intr_context ())
+		intr_yield_on_return ();
+	else
+		thread_yield ();
+}
+
+/* Sets the current thread's base priority to NEW_PRIORITY.  Its
+   effective priority stays raised while it holds a lock wanted
+   by a higher-priority thread.  Yields if that leaves a ready
+   thread with a higher priority.  Has no effect under the 4.4BSD
+   scheduler, which computes priorities itself. */
 void
 thread_set_priority (int new_priority) 
 {
-	thread_current ()->priority = new_priority;
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (PRI_MIN <= new_priority && new_priority <= PRI_MAX);
+
+	if (thread_mlfqs)
+		return;
+
+	old_level = intr_disable ();
+	cur->base_priority = new_priority;
+	thread_update_priority (cur);
+	intr_set_level (old_level);
+
+	thread_check_preempt ();
+}
+
+/* Returns the thread that T is waiting behind: the holder of
+   T's waiting_lock, or the writer holding T's waiting_rwlock, or
+   a null pointer.  Readers holding an rwlock are not tracked, so
+   they receive no donations. */
+static struct thread *
+donation_target (const struct thread *t)
+{
+	if (t->waiting_lock != NULL)
+		return t->waiting_lock->holder;
+	if (t->waiting_rwlock != NULL)
+		return t->waiting_rwlock->writer;
+	return NULL;
+}
+
+/* Donates DONOR's priority along the chain of lock holders that
+   DONOR is waiting behind: the holder of DONOR's waiting_lock (or
+   the writer of its waiting_rwlock), the holder of the lock that
+   thread is waiting for, and so on, for at most
+   DONATION_DEPTH_MAX links.  Stops early at the first holder that
+   already runs at DONOR's priority or higher, since everything
+   further along the chain must too.  Interrupts must be off. */
+void
+thread_donate_priority (struct thread *donor)
+{
+	struct thread *holder = donation_target (donor);
+	int priority = donor->priority;
+	int depth;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (depth = 0; holder != NULL && depth < DONATION_DEPTH_MAX; depth++)
+	{
+		if (holder->priority >= priority)
+			break;
+		change_priority (holder, priority);
+		holder = donation_target (holder);
+	}
+}
+
+/* Recomputes T's effective priority as the maximum of its base
+   priority and the priority of the highest-priority thread
+   waiting on any lock that T holds, or on any rwlock that T
+   holds for writing.  Only T's own donors are examined.
+   Interrupts must be off. */
+void
+thread_update_priority (struct thread *t)
+{
+	int priority = t->base_priority;
+	struct list_elem *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (e = list_begin (&t->lock_list); e != list_end (&t->lock_list);
+			e = list_next (e))
+	{
+		struct lock *lock = list_entry (e, struct lock, elem);
+		struct heap_elem *top = heap_top (&lock->semaphore.waiters);
+
+		if (top != NULL)
+		{
+			struct thread *donor = heap_entry (top, struct thread, wait_elem);
+			if (donor->priority > priority)
+				priority = donor->priority;
+		}
+	}
+	for (e = list_begin (&t->rwlock_list); e != list_end (&t->rwlock_list);
+			e = list_next (e))
+	{
+		struct rwlock *rw = list_entry (e, struct rwlock, elem);
+		struct list *waiters[] = { &rw->read_waiters, &rw->write_waiters };
+		size_t i;
+
+		for (i = 0; i < sizeof waiters / sizeof *waiters; i++)
+			if (!list_empty (waiters[i]))
+			{
+				struct thread *donor = list_entry (list_min (waiters[i],
+						thread_priority_comparator, NULL), struct thread, elem);
+				if (donor->priority > priority)
+					priority = donor->priority;
+			}
+	}
+	change_priority (t, priority);
+}
+
+/* Recomputes the priority of T, and then of each thread along
+   the chain of lock holders and rwlock writers that T is waiting
+   behind, for at most DONATION_DEPTH_MAX links.  Used when a
+   donor stops waiting without being granted what it waited
+   for.  Interrupts must be off. */
+void
+thread_update_priority_chain (struct thread *t)
+{
+	int depth;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (depth = 0; t != NULL && depth < DONATION_DEPTH_MAX; depth++)
+	{
+		thread_update_priority (t);
+		t = donation_target (t);
+	}
 }
 
 /* Returns the current thread's priority. */
@@ -375,51 +661,190 @@ thread_get_priority (void)
 	return thread_current ()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
+/* Sets the current thread's nice value to NICE and recomputes
+   its priority, yielding if it no longer has the highest
+   priority. */
 void
-thread_set_nice (int nice UNUSED) 
+thread_set_nice (int nice) 
 {
-	/* Not yet implemented. */
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (NICE_MIN <= nice && nice <= NICE_MAX);
+
+	old_level = intr_disable ();
+	cur->nice = nice;
+	if (thread_mlfqs)
+		cur->priority = mlfqs_priority (cur);
+	intr_set_level (old_level);
+
+	thread_check_preempt ();
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) 
 {
-	/* Not yet implemented. */
-	return 0;
+	return thread_current ()->nice;
+}
+
+/* Sets the current thread's number of tickets, its share of the
+   CPU under the stride scheduler, to TICKETS. */
+void
+thread_set_tickets (int tickets)
+{
+	enum intr_level old_level;
+
+	ASSERT (TICKETS_MIN <= tickets && tickets <= TICKETS_MAX);
+
+	old_level = intr_disable ();
+	thread_current ()->tickets = tickets;
+	intr_set_level (old_level);
+}
+
+/* Returns the current thread's number of tickets. */
+int
+thread_get_tickets (void)
+{
+	return thread_current ()->tickets;
+}
+
+/* Moves the current thread into the earliest-deadline-first
+   class, entitled to BUDGET ticks of CPU time in every PERIOD
+   ticks, starting now; or, if PERIOD is 0, back to the active
+   class.  Returns false, changing nothing, if PERIOD and BUDGET
+   are invalid or admitting them would overload the CPU. */
+bool
+thread_set_deadline (int period, int budget)
+{
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
+
+	if (period < 0 || (period > 0 && (budget <= 0 || budget > period)))
+		return false;
+
+	old_level = intr_disable ();
+	if (cur->edf_period != 0)
+		sched_edf_release (cur->edf_period, cur->edf_budget);
+	if (period != 0 && !sched_edf_reserve (period, budget))
+	{
+		if (cur->edf_period != 0)
+			sched_edf_reserve (cur->edf_period, cur->edf_budget);
+		intr_set_level (old_level);
+		return false;
+	}
+	cur->edf_period = period;
+	cur->edf_budget = budget;
+	cur->edf_used = 0;
+	cur->deadline = timer_ticks () + period;
+	intr_set_level (old_level);
+
+	thread_check_preempt ();
+	return true;
+}
+
+/* Returns the number of deadlines that the current thread has
+   missed as an EDF thread. */
+unsigned
+thread_get_deadline_misses (void)
+{
+	return thread_current ()->deadline_misses;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) 
 {
-	/* Not yet implemented. */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int load = fp_round (load_avg * 100);
+	intr_set_level (old_level);
+	return load;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) 
 {
-	/* Not yet implemented. */
-	return 0;
+	enum intr_level old_level = intr_disable ();
+	int recent = fp_round (thread_current ()->recent_cpu * 100);
+	intr_set_level (old_level);
+	return recent;
+}
+
+/* Returns the 4.4BSD priority of T:
+   PRI_MAX - (recent_cpu / 4) - (nice * 2), clamped to the valid
+   priority range. */
+static int
+mlfqs_priority (const struct thread *t)
+{
+	int priority = PRI_MAX - fp_to_int (t->recent_cpu / 4) - t->nice * 2;
+
+	if (priority < PRI_MIN)
+		return PRI_MIN;
+	if (priority > PRI_MAX)
+		return PRI_MAX;
+	return priority;
+}
+
+/* Decays T's recent_cpu by the current load average and
+   recomputes its priority, moving it to the matching run queue
+   if it is ready.  Called once per second for every thread. */
+static void
+mlfqs_update_priority (struct thread *t)
+{
+	fixed_t twice_load = load_avg * 2;
+	int priority;
+
+	if (t == cpu_current ()->idle_thread)
+		return;
+
+	t->recent_cpu = fp_add_int (fp_mul (fp_div (twice_load,
+					fp_add_int (twice_load, 1)), t->recent_cpu), t->nice);
+
+	priority = mlfqs_priority (t);
+	if (priority != t->priority)
+		change_priority (t, priority);
+}
+
+/* Once-per-second 4.4BSD bookkeeping: recomputes the load
+   average from the number of ready and running threads, then
+   decays every thread's recent_cpu and recomputes its
+   priority. */
+static void
+mlfqs_update_second (void)
+{
+	int ready_threads = ready_cnt;
+	struct list_elem *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (thread_current () != cpu_current ()->idle_thread)
+		ready_threads++;
+	load_avg = fp_mul (fp_div (fp_from_int (59), fp_from_int (60)), load_avg)
+		+ fp_from_int (ready_threads) / 60;
+
+	for (e = list_begin (&all_list); e != list_end (&all_list);
+			e = list_next (e))
+		mlfqs_update_priority (list_entry (e, struct thread, allelem));
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
 
    The idle thread is initially put on the ready list by
    thread_start().  It will be scheduled once initially, at which
-   point it initializes idle_thread, "up"s the semaphore passed
-   to it to enable thread_start() to continue, and immediately
-   blocks.  After that, the idle thread never appears in the
+   point it registers itself as its CPU's idle thread, "up"s the
+   semaphore passed to it to enable thread_start() to continue,
+   and immediately blocks.  After that, the idle thread never appears in the
    ready list.  It is returned by next_thread_to_run() as a
    special case when the ready list is empty. */
 static void
 idle (void *idle_started_ UNUSED) 
 {
 	struct semaphore *idle_started = idle_started_;
-	idle_thread = thread_current ();
+	struct thread *cur = thread_current ();
+
+	cpu_current ()->idle_thread = cur;
+	cur->priority = cur->base_priority = PRI_MIN;
 	sema_up (idle_started);
 
 	for (;;)
@@ -428,6 +853,10 @@ idle (void *idle_started_ UNUSED)
 		intr_disable ();
 		thread_block ();
 
+		/* In tickless mode, stop the periodic timer until the next
+		   thread is due to wake up. */
+		timer_idle_enter ();
+
 		/* Re-enable interrupts and wait for the next one.
 
          The `sti' instruction disables interrupts until the
@@ -489,14 +918,30 @@ init_thread (struct thread *t, const char *name, int priority)
 	t->status = THREAD_BLOCKED;
 	strlcpy (t->name, name, sizeof t->name);
 	t->stack = (uint8_t *) t + PGSIZE;
-	t->priority = priority;
+	t->priority = t->base_priority = priority;
+	t->sched_stamp = rdtsc ();
 	t->magic = THREAD_MAGIC;
+
+	/* Under the 4.4BSD scheduler, a new thread inherits its
+	   parent's nice and recent_cpu, and its priority is computed
+	   from them rather than given by the caller. */
+	t->nice = NICE_DEFAULT;
+	t->recent_cpu = 0;
+	if (t != running_thread ())
+	{
+		t->nice = running_thread ()->nice;
+		t->recent_cpu = running_thread ()->recent_cpu;
+	}
+	if (thread_mlfqs)
+		t->priority = t->base_priority = mlfqs_priority (t);
+	t->tickets = TICKETS_DEFAULT;
 	list_push_back (&all_list, &t->allelem);
 
 	/* thread list member initialization */
 	t->executable = NULL;
 
 	list_init(&t->lock_list);
+	list_init (&t->rwlock_list);
 	list_init(&t->file_list);
 	list_init(&t->child_list);
 	t->fd = 2;
@@ -517,18 +962,227 @@ alloc_frame (struct thread *t, size_t size)
 	return t->stack;
 }
 
+/* Returns the index of the most significant set bit in X,
+   which must be nonzero.  See [IA32-v2a] "BSR". */
+static inline int
+highest_bit (uint32_t x)
+{
+	uint32_t bit;
+
+	asm ("bsrl %1, %0" : "=r" (bit) : "rm" (x) : "cc");
+	return bit;
+}
+
+/* Appends T to the tail of the run queue for its priority.
+   Interrupts must be off. */
+static void
+ready_queue_push (struct thread *t)
+{
+	int pri = t->priority;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (PRI_MIN <= pri && pri <= PRI_MAX);
+
+	list_push_back (&ready_queues[pri], &t->elem);
+	ready_bitmap[pri / 32] |= 1u << (pri % 32);
+}
+
+/* Removes T, which must be ready, from its run queue.
+   Interrupts must be off. */
+static void
+ready_queue_remove (struct thread *t)
+{
+	int pri = t->priority;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (t->status == THREAD_READY);
+
+	list_remove (&t->elem);
+	if (list_empty (&ready_queues[pri]))
+		ready_bitmap[pri / 32] &= ~(1u << (pri % 32));
+}
+
+/* Sets T's effective priority to PRIORITY, letting the
+   scheduling class reposition T if it is ready, and re-sifting T
+   in the heap it is waiting in, if any.  Interrupts must be
+   off. */
+static void
+change_priority (struct thread *t, int priority)
+{
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	thread_sched_class (t)->set_priority (t, priority);
+	if (t->wait_heap != NULL)
+		heap_update (t->wait_heap, t->wait_node);
+}
+
+/* Returns the scheduling class that T belongs to. */
+static const struct sched_class *
+thread_sched_class (const struct thread *t)
+{
+	return t->edf_period != 0 ? &sched_edf_class : sched_class;
+}
+
+/* Makes T, which is becoming ready, known to its scheduling
+   class.  Interrupts must be off. */
+static void
+ready_enqueue (struct thread *t)
+{
+	thread_sched_class (t)->enqueue (t);
+	ready_cnt++;
+}
+
+/* Returns the highest priority that has a ready thread, or -1
+   if no thread is ready.  Interrupts must be off. */
+static int
+ready_queue_max_priority (void)
+{
+	int i;
+
+	for (i = sizeof ready_bitmap / sizeof *ready_bitmap - 1; i >= 0; i--)
+		if (ready_bitmap[i] != 0)
+			return i * 32 + highest_bit (ready_bitmap[i]);
+	return -1;
+}
+
+/* Removes and returns the thread at the head of the
+   highest-priority nonempty run queue, or NULL if no thread is
+   ready.  Interrupts must be off. */
+static struct thread *
+ready_queue_pop (void)
+{
+	int pri = ready_queue_max_priority ();
+	struct list *queue;
+	struct thread *t;
+
+	if (pri < 0)
+		return NULL;
+
+	queue = &ready_queues[pri];
+	t = list_entry (list_pop_front (queue), struct thread, elem);
+	if (list_empty (queue))
+		ready_bitmap[pri / 32] &= ~(1u << (pri % 32));
+	return t;
+}
+
+/* Initializes the run queues. */
+static void
+ready_queue_init (void)
+{
+	int i;
+
+	for (i = 0; i <= PRI_MAX; i++)
+		list_init (&ready_queues[i]);
+}
+
+/* Returns true if a ready thread has a higher priority than
+   CUR.  Interrupts must be off. */
+static bool
+ready_queue_preempt (const struct thread *cur)
+{
+	return ready_queue_max_priority () > cur->priority;
+}
+
+/* Sets T's effective priority to PRIORITY, moving T to the
+   matching run queue if it is ready.  Interrupts must be off. */
+static void
+ready_queue_set_priority (struct thread *t, int priority)
+{
+	if (t->status == THREAD_READY)
+	{
+		ready_queue_remove (t);
+		t->priority = priority;
+		ready_queue_push (t);
+	}
+	else
+		t->priority = priority;
+}
+
+/* Timer tick for the priority scheduler: round-robin among
+   threads of equal priority, TIME_SLICE ticks apiece. */
+static bool
+priority_tick (struct thread *cur UNUSED, unsigned slice_ticks)
+{
+	return slice_ticks >= TIME_SLICE;
+}
+
+/* Timer tick for the 4.4BSD scheduler: charges the tick to CUR's
+   recent_cpu and does the periodic bookkeeping, then enforces
+   the same time slice as the priority scheduler. */
+static bool
+mlfqs_tick (struct thread *cur, unsigned slice_ticks)
+{
+	bool idle = cur == cpu_current ()->idle_thread;
+
+	if (!idle)
+		cur->recent_cpu = fp_add_int (cur->recent_cpu, 1);
+	if (timer_ticks () % TIMER_FREQ == 0)
+		mlfqs_update_second ();
+	else if (timer_ticks () % MLFQS_PRI_TICKS == 0 && !idle)
+		cur->priority = mlfqs_priority (cur);
+	return slice_ticks >= TIME_SLICE;
+}
+
+/* Strict priority scheduling with priority donation. */
+const struct sched_class sched_priority_class =
+	{
+		.name = "priority",
+		.init = ready_queue_init,
+		.enqueue = ready_queue_push,
+		.pick_next = ready_queue_pop,
+		.preempt = ready_queue_preempt,
+		.tick = priority_tick,
+		.set_priority = ready_queue_set_priority,
+	};
+
+/* 4.4BSD multi-level feedback queue scheduling, on the same run
+   queues, with priorities computed from nice and recent_cpu. */
+const struct sched_class sched_mlfqs_class =
+	{
+		.name = "mlfqs",
+		.init = ready_queue_init,
+		.enqueue = ready_queue_push,
+		.pick_next = ready_queue_pop,
+		.preempt = ready_queue_preempt,
+		.tick = mlfqs_tick,
+		.set_priority = ready_queue_set_priority,
+	};
+
+/* Selects the scheduling class named NAME, which must happen
+   before thread_init().  Returns true if successful, false if
+   there is no such class. */
+bool
+sched_select (const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof sched_classes / sizeof *sched_classes; i++)
+		if (!strcmp (sched_classes[i]->name, name))
+		{
+			sched_class = sched_classes[i];
+			thread_mlfqs = sched_class == &sched_mlfqs_class;
+			return true;
+		}
+	return false;
+}
+
 /* Chooses and returns the next thread to be scheduled.  Should
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
-   will be in the run queue.)  If the run queue is empty, return
-   idle_thread. */
+   will be in the run queue.)  Ready EDF threads come ahead of
+   those of the active class.  If the run queue is empty, return
+   the CPU's idle thread. */
 static struct thread *
 next_thread_to_run (void) 
 {
-	if (list_empty (&ready_list))
-		return idle_thread;
-	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+	struct thread *t = sched_edf_class.pick_next ();
+
+	if (t == NULL)
+		t = sched_class->pick_next ();
+	if (t == NULL)
+		return cpu_current ()->idle_thread;
+	ready_cnt--;
+	return t;
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -551,18 +1205,33 @@ void
 thread_schedule_tail (struct thread *prev)
 {
 	struct thread *cur = running_thread ();
+	uint64_t now = rdtsc ();
+	uint64_t waited = now - cur->sched_stamp;
 
 	ASSERT (intr_get_level () == INTR_OFF);
 
 	/* Mark us as running. */
 	cur->status = THREAD_RUNNING;
 
+	/* Account for the time we spent ready, and, if we were just
+	   woken up, record how long that took in the histogram. */
+	cur->wait_cycles += waited;
+	cur->sched_stamp = now;
+	if (cur->woken)
+	{
+		int bucket = (waited >> 32 != 0 ? SCHEDSTAT_BUCKETS - 1
+				: waited == 0 ? 0 : highest_bit (waited));
+		latency_hist[bucket]++;
+		cur->woken = false;
+	}
+
 	/* Start new time slice. */
 	thread_ticks = 0;
 
 #ifdef USERPROG
 	/* Activate the new address space. */
 	process_activate ();
+	fpu_activate ();
 #endif
 
 	/* If the thread we switched from is dying, destroy its struct
@@ -573,10 +1242,49 @@ thread_schedule_tail (struct thread *prev)
 	if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread)
 	{
 		ASSERT (prev != cur);
-		palloc_free_page (prev);
+		add_thread_stats (&exited_stats, prev);
+		thread_page_free (prev);
 	}
 }
 
+/* Returns a page for a new thread, taken from the thread page
+   cache if possible, or a null pointer if no memory is
+   available.  The page is not zeroed; init_thread() clears the
+   struct thread. */
+static struct thread *
+thread_page_alloc (void)
+{
+	struct thread *t = NULL;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	if (thread_cache_cnt > 0)
+	{
+		t = thread_cache[--thread_cache_cnt];
+		thread_cache_hits++;
+	}
+	else
+		thread_cache_misses++;
+	intr_set_level (old_level);
+
+	if (t == NULL)
+		t = palloc_get_page (0);
+	return t;
+}
+
+/* Frees the page of dead thread T, keeping it in the thread page
+   cache if there is room.  Interrupts must be off. */
+static void
+thread_page_free (struct thread *t)
+{
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (thread_cache_cnt < THREAD_CACHE_SIZE)
+		thread_cache[thread_cache_cnt++] = t;
+	else
+		palloc_free_page (t);
+}
+
 /* Schedules a new process.  At entry, interrupts must be off and
    the running process's state must have been changed from
    running to some other state.  This function finds another
@@ -591,12 +1299,25 @@ schedule (void)
 	struct thread *next = next_thread_to_run ();
 	struct thread *prev = NULL;
 
+	uint64_t now = rdtsc ();
+
 	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT (cur->status != THREAD_RUNNING);
 	ASSERT (is_thread (next));
 
+	/* Charge the running time to CUR.  From here on, its stamp
+	   marks when it became ready (if it is ready). */
+	cur->run_cycles += now - cur->sched_stamp;
+	cur->sched_stamp = now;
+
 	if (cur != next)
+	{
+		if (cur->status == THREAD_READY)
+			cur->involuntary_switches++;
+		else
+			cur->voluntary_switches++;
 		prev = switch_threads (cur, next);
+	}
 	thread_schedule_tail (prev);
 }
 
@@ -632,18 +1353,6 @@ release_locks (struct thread * t){
 	 }
 }
 
-/* check if the thread of given pid is still alive */
-void
-is_thread_alive(struct thread *t, void *aux){
-
-	if(foreach_finished){
-		return;
-	}else if(t->tid == (int) aux){
-		thread_alive = true;
-		foreach_finished = true;
-	}
-}
-
 /* Comparator for priority-based insertion into the ready list. */
 bool
 thread_priority_comparator(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
@@ -652,10 +1361,3 @@ thread_priority_comparator(const struct list_elem *a, const struct list_elem *b,
     const struct thread *t_b = list_entry(b, struct thread, elem);
     return t_a->priority > t_b->priority;
 }
-
-/* reset flags to default status (false) */
-void
-flag_reset(void){
-	thread_alive = false;
-	foreach_finished = false;
-}
\ No newline at end of file
@@ -2,9 +2,14 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <hash.h>
 #include <list.h>
+#include <schedstat.h>
 #include <stdint.h>
+#include "threads/fixed-point.h"
+#include "threads/malloc.h"
 #include "threads/synch.h"
+#include "devices/timer.h"
 
 /* IPC buffer size */
 #define IPC_BUFFER_SIZE 128
@@ -37,7 +42,25 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
-/* struct to store information of child process */
+/* Maximum length of a chain of nested priority donations.
+   Bounds the work done by lock_acquire() and breaks cycles. */
+#define DONATION_DEPTH_MAX 8
+
+/* Thread niceness, for the 4.4BSD scheduler. */
+#define NICE_MIN -20                    /* Nicest to other threads. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Least nice. */
+
+/* Thread tickets, for the stride scheduler.  A ready thread's
+   share of the CPU is proportional to its tickets. */
+#define TICKETS_MIN 1                   /* Smallest share. */
+#define TICKETS_DEFAULT 100             /* Default share. */
+#define TICKETS_MAX 1000                /* Largest share. */
+
+/* struct to store information of child process.  Shared by the
+   parent, which finds it by pid in the process table, and the
+   child, which points to it with its `cp' member.  Each holds a
+   reference, and the last to let go frees it. */
 struct child_process {
 	int pid;
 	int load;
@@ -46,7 +69,10 @@ struct child_process {
 	bool exit;
 	struct semaphore load_sema;
 	struct semaphore exit_sema;
-	struct list_elem elem;
+	struct list_elem elem;          /* Element in parent's child_list. */
+	struct hash_elem hash_elem;     /* Element in the process table. */
+	tid_t parent;                   /* Parent's tid, or TID_ERROR if gone. */
+	int ref_cnt;                    /* Parent and child references. */
 };
 
 /* A kernel thread or user process.
@@ -99,12 +125,14 @@ struct child_process {
    the `magic' member of the running thread's `struct thread' is
    set to THREAD_MAGIC.  Stack overflow will normally change this
    value, triggering the assertion. */
-/* The `elem' member has a dual purpose.  It can be an element in
-   the run queue (thread.c), or it can be an element in a
-   semaphore wait list (synch.c).  It can be used these two ways
-   only because they are mutually exclusive: only a thread in the
+/* The `elem' member has a triple purpose.  It can be an element
+   in the run queue (thread.c), an element in a semaphore wait
+   list (synch.c), or an element in the timer's sleep list
+   (devices/timer.c).  It can be used these three ways only
+   because they are mutually exclusive: only a thread in the
    ready state is on the run queue, whereas only a thread in the
-   blocked state is on a semaphore wait list. */
+   blocked state is on a semaphore wait list or the sleep list,
+   and a sleeping thread is not waiting on any semaphore. */
 struct thread
   {
     /* Owned by thread.c. */
@@ -112,22 +140,60 @@ struct thread
     enum thread_status status;          /* Thread state. */
     char name[16];                      /* Name (for debugging purposes). */
     uint8_t *stack;                     /* Saved stack pointer. */
-    int priority;                       /* Priority. */
+    int priority;                       /* Effective priority. */
+    int base_priority;                  /* Priority before donation. */
+    int nice;                           /* Niceness, for the 4.4BSD scheduler. */
+    fixed_t recent_cpu;                 /* Recent CPU time, for the 4.4BSD scheduler. */
+    int tickets;                        /* CPU share, for the stride scheduler. */
+    int64_t pass;                       /* Virtual time, for the stride scheduler. */
+    struct heap_elem sched_elem;        /* Run queue element, for stride and EDF. */
+    int edf_period;                     /* EDF period in ticks, or 0 if not EDF. */
+    int edf_budget;                     /* EDF ticks allowed per period. */
+    int edf_used;                       /* EDF ticks used this period. */
+    int64_t deadline;                   /* End of current EDF period. */
+    bool edf_throttled;                 /* Out of budget until deadline? */
+    struct timer_event edf_event;       /* Ends throttling at deadline. */
+    unsigned deadline_misses;           /* EDF periods ended short of budget. */
     struct list_elem allelem;           /* List element for all threads list. */
 
-    /* Shared between thread.c and synch.c. */
+    /* Shared between thread.c, synch.c and devices/timer.c. */
     struct list_elem elem;              /* List element. */
 
+    /* Owned by devices/timer.c. */
+    int64_t wakeup_tick;                /* Tick to wake up at, if sleeping. */
+
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
+
+    /* Owned by userprog/fpu.c. */
+    void *fpu_save;                     /* FPU save area, or null. */
 #endif
 
+    /* Scheduler accounting, owned by thread.c. */
+    uint64_t run_cycles;                /* TSC cycles spent running. */
+    uint64_t wait_cycles;               /* TSC cycles spent ready. */
+    uint64_t sched_stamp;               /* TSC when last run or made ready. */
+    unsigned voluntary_switches;        /* Switches away by blocking. */
+    unsigned involuntary_switches;      /* Switches away while ready. */
+    bool woken;                         /* Unblocked since last run? */
+
+    /* Owned by malloc.c. */
+    struct malloc_magazine malloc_mags[MALLOC_CLASSES];
+
     /* Owned by thread.c. */
     unsigned magic;                     /* Detects stack overflow. */
 
     /* locks current thread holding */
     struct list lock_list;
+    struct list rwlock_list;            /* Rwlocks held for writing. */
+
+    /* Shared between thread.c and synch.c. */
+    struct lock *waiting_lock;          /* Lock being waited for, if any. */
+    struct rwlock *waiting_rwlock;      /* Rwlock being waited for, if any. */
+    struct heap_elem wait_elem;         /* Semaphore wait heap element. */
+    struct heap *wait_heap;             /* Priority-ordered wait heap, if any. */
+    struct heap_elem *wait_node;        /* This thread's node in wait_heap. */
 
     /* file system syscall */
     struct list file_list;
@@ -144,9 +210,9 @@ struct thread
     struct file* executable;
   };
 
-/* If false (default), use round-robin scheduler.
-   If true, use multi-level feedback queue scheduler.
-   Controlled by kernel command-line option "-o mlfqs". */
+/* True if the multi-level feedback queue scheduler is active.
+   Controlled by kernel command-line option "-mlfqs" or
+   "-sched=mlfqs". */
 extern bool thread_mlfqs;
 
 void thread_init (void);
@@ -154,6 +220,8 @@ void thread_start (void);
 
 void thread_tick (void);
 void thread_print_stats (void);
+long long thread_get_idle_ticks (void);
+void thread_get_schedstat (struct schedstat *);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
@@ -167,6 +235,7 @@ const char *thread_name (void);
 
 void thread_exit (void) NO_RETURN;
 void thread_yield (void);
+void thread_check_preempt (void);
 
 /* Performs some operation on thread t, given auxiliary data AUX. */
 typedef void thread_action_func (struct thread *t, void *aux);
@@ -174,14 +243,19 @@ void thread_foreach (thread_action_func *, void *);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
+void thread_donate_priority (struct thread *donor);
+void thread_update_priority (struct thread *);
+void thread_update_priority_chain (struct thread *);
 
 int thread_get_nice (void);
 void thread_set_nice (int);
+int thread_get_tickets (void);
+void thread_set_tickets (int);
+bool thread_set_deadline (int period, int budget);
+unsigned thread_get_deadline_misses (void);
 int thread_get_recent_cpu (void);
 int thread_get_load_avg (void);
 
-void is_thread_alive(struct thread *t, void *aux);
 bool thread_priority_comparator(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
-void flag_reset(void);
 
 #endif /* threads/thread.h */
\ No newline at end of file
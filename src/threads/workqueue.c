@@ -0,0 +1,188 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stddef.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Shared workqueues. */
+struct workqueue system_wq;
+struct workqueue system_highpri_wq;
+
+static thread_func worker_thread;
+static void delayed_work_fire (struct timer_event *);
+static void flush_work_func (struct work *);
+
+/* Creates the shared workqueues.  Must be called after
+   thread_start(). */
+void
+workqueue_init (void)
+{
+  if (!workqueue_create (&system_wq, "kworker", PRI_DEFAULT)
+      || !workqueue_create (&system_highpri_wq, "kworker-hi", PRI_MAX))
+    PANIC ("cannot create workqueue threads");
+}
+
+/* Initializes WQ and starts its worker thread, named NAME, at
+   PRIORITY.  Returns true if successful, false if the thread
+   could not be created. */
+bool
+workqueue_create (struct workqueue *wq, const char *name, int priority)
+{
+  ASSERT (wq != NULL);
+  ASSERT (name != NULL);
+
+  wq->name = name;
+  list_init (&wq->works);
+  sema_init (&wq->ready, 0);
+  wq->worker = NULL;
+  return thread_create (name, priority, worker_thread, wq) != TID_ERROR;
+}
+
+/* Initializes W to call FUNC, which can find AUX in W->aux. */
+void
+work_init (struct work *w, work_func *func, void *aux)
+{
+  ASSERT (w != NULL);
+  ASSERT (func != NULL);
+
+  w->func = func;
+  w->aux = aux;
+  w->pending = false;
+  w->wq = NULL;
+  timer_event_init (&w->timer, delayed_work_fire);
+}
+
+/* Appends W to WQ.  Returns true if W was queued, false if it
+   was already pending.  May be called from an interrupt
+   handler. */
+bool
+work_queue (struct workqueue *wq, struct work *w)
+{
+  enum intr_level old_level;
+  bool queued = false;
+
+  ASSERT (wq != NULL);
+  ASSERT (w != NULL);
+
+  old_level = intr_disable ();
+  if (!w->pending)
+    {
+      w->pending = true;
+      w->wq = wq;
+      list_push_back (&wq->works, &w->elem);
+      sema_up (&wq->ready);
+      queued = true;
+    }
+  intr_set_level (old_level);
+  return queued;
+}
+
+/* Appends W to WQ after TICKS timer ticks, or at once if TICKS
+   is not positive.  Returns true if W was scheduled, false if it
+   was already pending.  May be called from an interrupt
+   handler. */
+bool
+work_queue_delayed (struct workqueue *wq, struct work *w, int64_t ticks)
+{
+  enum intr_level old_level;
+  bool queued = false;
+
+  ASSERT (wq != NULL);
+  ASSERT (w != NULL);
+
+  if (ticks <= 0)
+    return work_queue (wq, w);
+
+  old_level = intr_disable ();
+  if (!w->pending)
+    {
+      w->pending = true;
+      w->wq = wq;
+      timer_event_add (&w->timer, timer_ticks () + ticks);
+      queued = true;
+    }
+  intr_set_level (old_level);
+  return queued;
+}
+
+/* Called from the timer interrupt when a delayed work's delay
+   runs out.  Moves the work onto its queue. */
+static void
+delayed_work_fire (struct timer_event *e)
+{
+  struct work *w = (struct work *) ((uint8_t *) e
+                                    - offsetof (struct work, timer));
+
+  list_push_back (&w->wq->works, &w->elem);
+  sema_up (&w->wq->ready);
+}
+
+/* Cancels W if it is pending.  Returns true if W was cancelled
+   before it started to run, false otherwise.  Does not wait for
+   a run of W that is already in progress.  Only delayed work can
+   be cancelled once it is on its queue's list; work queued with
+   work_queue() always runs. */
+bool
+work_cancel (struct work *w)
+{
+  enum intr_level old_level;
+  bool cancelled;
+
+  ASSERT (w != NULL);
+
+  old_level = intr_disable ();
+  cancelled = w->pending && timer_event_cancel (&w->timer);
+  if (cancelled)
+    w->pending = false;
+  intr_set_level (old_level);
+  return cancelled;
+}
+
+/* Waits until all the work queued on WQ before the call has
+   run.  Delayed work that is still waiting for its delay is not
+   waited for.  Must not be called from WQ's own worker thread,
+   which would wait for itself. */
+void
+work_flush (struct workqueue *wq)
+{
+  struct semaphore done;
+  struct work barrier;
+
+  ASSERT (!intr_context ());
+  ASSERT (wq->worker != thread_current ());
+
+  sema_init (&done, 0);
+  work_init (&barrier, flush_work_func, &done);
+  work_queue (wq, &barrier);
+  sema_down (&done);
+}
+
+/* Work function for work_flush()'s barrier. */
+static void
+flush_work_func (struct work *w)
+{
+  sema_up (w->aux);
+}
+
+/* Worker thread for the workqueue in WQ_: runs queued work,
+   oldest first, forever. */
+static void
+worker_thread (void *wq_)
+{
+  struct workqueue *wq = wq_;
+
+  wq->worker = thread_current ();
+  for (;;)
+    {
+      enum intr_level old_level;
+      struct work *w;
+
+      sema_down (&wq->ready);
+      old_level = intr_disable ();
+      w = list_entry (list_pop_front (&wq->works), struct work, elem);
+      w->pending = false;
+      intr_set_level (old_level);
+
+      w->func (w);
+    }
+}
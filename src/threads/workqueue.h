@@ -0,0 +1,63 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "devices/timer.h"
+#include "threads/synch.h"
+
+/* Deferred work.
+
+   A workqueue runs functions, one at a time and in the order in
+   which they were queued, in a dedicated kernel thread.  An
+   interrupt handler can queue work to do the part of its job
+   that need not happen with interrupts off, keeping its own
+   interrupts-off window short.
+
+   A struct work is embedded by its user and must not be freed or
+   reused while it is pending.  Queueing a work that is already
+   pending does nothing, so a handler that fires repeatedly
+   before the work runs gets a single call. */
+
+struct work;
+struct workqueue;
+
+/* Function run for a work item, in its workqueue's thread. */
+typedef void work_func (struct work *);
+
+/* A unit of deferred work. */
+struct work
+  {
+    struct list_elem elem;      /* Element in the queue's list. */
+    work_func *func;            /* Function to call. */
+    void *aux;                  /* Auxiliary data for FUNC. */
+    bool pending;               /* Queued or delayed, not yet run? */
+    struct workqueue *wq;       /* Target of a delayed queueing. */
+    struct timer_event timer;   /* Delay for work_queue_delayed(). */
+  };
+
+/* A queue of work and the thread that runs it. */
+struct workqueue
+  {
+    const char *name;           /* Name of the worker thread. */
+    struct list works;          /* Queued work, oldest first. */
+    struct semaphore ready;     /* Number of queued works. */
+    struct thread *worker;      /* The worker thread. */
+  };
+
+/* Shared workqueues, at two priorities.  Work that must not wait
+   behind ordinary threads belongs on system_highpri_wq. */
+extern struct workqueue system_wq;
+extern struct workqueue system_highpri_wq;
+
+void workqueue_init (void);
+bool workqueue_create (struct workqueue *, const char *name, int priority);
+
+void work_init (struct work *, work_func *, void *aux);
+bool work_queue (struct workqueue *, struct work *);
+bool work_queue_delayed (struct workqueue *, struct work *, int64_t ticks);
+bool work_cancel (struct work *);
+void work_flush (struct workqueue *);
+
+#endif /* threads/workqueue.h */
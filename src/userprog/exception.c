@@ -1,6 +1,7 @@
 #include "userprog/exception.h"
 #include <inttypes.h>
 #include <stdio.h>
+#include "userprog/fpu.h"
 #include "userprog/gdt.h"
 #include <user/syscall.h>
 #include "threads/interrupt.h"
@@ -11,6 +12,7 @@ static long long page_fault_cnt;
 
 static void kill (struct intr_frame *);
 static void page_fault (struct intr_frame *);
+static void device_not_available (struct intr_frame *);
 
 /* Registers handlers for interrupts that can be caused by user
    programs.
@@ -46,8 +48,6 @@ exception_init (void)
   intr_register_int (0, 0, INTR_ON, kill, "#DE Divide Error");
   intr_register_int (1, 0, INTR_ON, kill, "#DB Debug Exception");
   intr_register_int (6, 0, INTR_ON, kill, "#UD Invalid Opcode Exception");
-  intr_register_int (7, 0, INTR_ON, kill,
-                     "#NM Device Not Available Exception");
   intr_register_int (11, 0, INTR_ON, kill, "#NP Segment Not Present");
   intr_register_int (12, 0, INTR_ON, kill, "#SS Stack Fault Exception");
   intr_register_int (13, 0, INTR_ON, kill, "#GP General Protection Exception");
@@ -59,6 +59,11 @@ exception_init (void)
      We need to disable interrupts for page faults because the
      fault address is stored in CR2 and needs to be preserved. */
   intr_register_int (14, 0, INTR_OFF, page_fault, "#PF Page-Fault Exception");
+
+  /* #NM hands the FPU to a new thread, which must not be
+     preempted halfway through. */
+  intr_register_int (7, 0, INTR_OFF, device_not_available,
+                     "#NM Device Not Available Exception");
 }
 
 /* Prints exception statistics. */
@@ -159,3 +164,20 @@ page_fault (struct intr_frame *f)
           user ? "user" : "kernel");
   kill (f);
 }
+
+/* Device-not-available handler.  fpu_activate() sets CR0.TS
+   when it switches in a thread that does not own the FPU, so the
+   thread's first floating-point instruction lands here.  Hands it
+   the FPU, then returns to retry the instruction.
+
+   The kernel is compiled with -msoft-float, so only user code
+   should ever get here. */
+static void
+device_not_available (struct intr_frame *f)
+{
+  if (f->cs == SEL_UCSEG && fpu_claim ())
+    return;
+
+  intr_enable ();
+  kill (f);
+}
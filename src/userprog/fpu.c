@@ -0,0 +1,195 @@
+#include "userprog/fpu.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+
+/* Lazy x87/SSE context switching.
+
+   switch_threads() and struct intr_frame save only the integer
+   registers.  Saving the 512-byte floating-point state on every
+   switch as well would slow down every thread to benefit the few
+   that use it, so instead the FPU belongs to one thread at a time,
+   fpu_owner, and its registers hold that thread's state even while
+   other threads run.
+
+   fpu_activate() sets CR0.TS whenever any other thread is
+   switched in, so that its first x87, MMX, or SSE instruction
+   raises #NM.  The #NM handler calls fpu_claim(), which saves the
+   registers into the owner's save area, loads the current
+   thread's, and makes it the owner.  A thread that never uses the
+   FPU never pays for it, and one that is the only FPU user is
+   never saved or restored at all.
+
+   See [IA32-v3a] section 13.4 "Designing OS Facilities for Saving
+   x87 FPU, SSE and Extended States on Task or Context Switches". */
+
+/* CR0 bits. */
+#define CR0_MP 0x00000002       /* Monitor Coprocessor. */
+#define CR0_EM 0x00000004       /* Emulation. */
+#define CR0_TS 0x00000008       /* Task Switched. */
+#define CR0_NE 0x00000020       /* Numeric Error. */
+
+/* CR4 bits. */
+#define CR4_OSFXSR 0x00000200     /* FXSAVE/FXRSTOR and SSE enabled. */
+#define CR4_OSXMMEXCPT 0x00000400 /* SSE exceptions raise #XF. */
+
+/* CPUID leaf 1 EDX feature bits. */
+#define CPUID_FXSR 0x01000000   /* FXSAVE and FXRSTOR. */
+#define CPUID_SSE 0x02000000    /* SSE. */
+
+/* FXSAVE image.  Without FXSR, FNSAVE's 108-byte image is stored
+   at the start instead. */
+struct fpu_state
+  {
+    uint8_t data[512];
+  };
+
+/* Required alignment of struct fpu_state. */
+#define FPU_ALIGN 16
+
+/* Thread whose state is in the FPU registers, or a null
+   pointer. */
+static struct thread *fpu_owner;
+
+/* Use FXSAVE and FXRSTOR? */
+static bool use_fxsr;
+
+/* State of a thread's first FPU instruction, as set up by FNINIT
+   plus the default MXCSR. */
+static struct fpu_state initial_state __attribute__ ((aligned (FPU_ALIGN)));
+
+static uint32_t
+read_cr0 (void)
+{
+  uint32_t cr0;
+  asm volatile ("movl %%cr0, %0" : "=r" (cr0));
+  return cr0;
+}
+
+static void
+write_cr0 (uint32_t cr0)
+{
+  asm volatile ("movl %0, %%cr0" : : "r" (cr0));
+}
+
+static void
+fpu_save (struct fpu_state *s)
+{
+  if (use_fxsr)
+    asm volatile ("fxsave %0" : "=m" (*s));
+  else
+    asm volatile ("fnsave %0" : "=m" (*s));
+}
+
+static void
+fpu_restore (const struct fpu_state *s)
+{
+  if (use_fxsr)
+    asm volatile ("fxrstor %0" : : "m" (*s));
+  else
+    asm volatile ("frstor %0" : : "m" (*s));
+}
+
+/* Returns T's save area. */
+static struct fpu_state *
+fpu_area (struct thread *t)
+{
+  return (struct fpu_state *) ROUND_UP ((uintptr_t) t->fpu_save, FPU_ALIGN);
+}
+
+/* Enables the FPU, and SSE if the CPU has it, and records the
+   state that every thread's FPU starts out in. */
+void
+fpu_init (void)
+{
+  uint32_t eax, ebx, ecx, edx;
+  uint32_t cr4;
+
+  asm ("cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (1));
+  use_fxsr = (edx & CPUID_FXSR) != 0;
+  if (use_fxsr)
+    {
+      asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+      cr4 |= CR4_OSFXSR;
+      if (edx & CPUID_SSE)
+        cr4 |= CR4_OSXMMEXCPT;
+      asm volatile ("movl %0, %%cr4" : : "r" (cr4));
+    }
+
+  /* Use the FPU itself rather than emulating it, report its
+     errors as #MF, and make WAIT honor CR0.TS. */
+  write_cr0 ((read_cr0 () & ~(CR0_EM | CR0_TS)) | CR0_MP | CR0_NE);
+  asm volatile ("fninit");
+  fpu_save (&initial_state);
+  write_cr0 (read_cr0 () | CR0_TS);
+}
+
+/* Sets CR0.TS unless the running thread owns the FPU.
+   This function is called on every context switch. */
+void
+fpu_activate (void)
+{
+  uint32_t cr0 = read_cr0 ();
+  uint32_t want = (fpu_owner == thread_current ()
+                   ? cr0 & ~CR0_TS : cr0 | CR0_TS);
+
+  /* Writing CR0 serializes the CPU, so avoid it when possible. */
+  if (want != cr0)
+    write_cr0 (want);
+}
+
+/* Gives the FPU to the running thread, saving the previous
+   owner's state and loading ours.  Called from the #NM handler
+   with interrupts off.  Returns false if there was no memory for
+   a save area. */
+bool
+fpu_claim (void)
+{
+  struct thread *cur = thread_current ();
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (cur->fpu_save == NULL)
+    {
+      void *buf;
+
+      intr_enable ();
+      buf = malloc (sizeof (struct fpu_state) + FPU_ALIGN - 1);
+      intr_disable ();
+      if (buf == NULL)
+        return false;
+      cur->fpu_save = buf;
+      memcpy (fpu_area (cur), &initial_state, sizeof initial_state);
+    }
+
+  asm volatile ("clts");
+  if (fpu_owner != cur)
+    {
+      if (fpu_owner != NULL)
+        fpu_save (fpu_area (fpu_owner));
+      fpu_restore (fpu_area (cur));
+      fpu_owner = cur;
+    }
+  return true;
+}
+
+/* Frees T's save area.  T must be the running thread, which will
+   not use the FPU again. */
+void
+fpu_release (struct thread *t)
+{
+  enum intr_level old_level = intr_disable ();
+  if (fpu_owner == t)
+    {
+      fpu_owner = NULL;
+      write_cr0 (read_cr0 () | CR0_TS);
+    }
+  intr_set_level (old_level);
+
+  free (t->fpu_save);
+  t->fpu_save = NULL;
+}
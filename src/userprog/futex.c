@@ -0,0 +1,121 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* A queue of threads sleeping on one futex word.  Queues are
+   keyed by the owning address space and the user virtual address
+   of the word, created when the first waiter arrives and freed
+   when the last one leaves. */
+struct futex_queue {
+    struct hash_elem elem;     /* Element in futex_table. */
+    uint32_t *pagedir;         /* Address space of the word. */
+    const int *uaddr;          /* User virtual address of the word. */
+    struct list waiters;       /* List of struct futex_waiter. */
+};
+
+/* A thread blocked in futex_wait(), allocated on its stack. */
+struct futex_waiter {
+    struct list_elem elem;     /* Element in futex_queue's waiters. */
+    struct semaphore sema;     /* Upped by futex_wake(). */
+};
+
+static struct hash futex_table;
+static struct lock futex_lock; /* Protects futex_table and all queues. */
+
+static unsigned futex_hash(const struct hash_elem *e, void *aux UNUSED) {
+    const struct futex_queue *q = hash_entry(e, struct futex_queue, elem);
+    return hash_int((int)(uintptr_t)q->pagedir ^ (int)(uintptr_t)q->uaddr);
+}
+
+static bool futex_less(const struct hash_elem *a_, const struct hash_elem *b_,
+                       void *aux UNUSED) {
+    const struct futex_queue *a = hash_entry(a_, struct futex_queue, elem);
+    const struct futex_queue *b = hash_entry(b_, struct futex_queue, elem);
+    if (a->pagedir != b->pagedir) {
+        return a->pagedir < b->pagedir;
+    }
+    return a->uaddr < b->uaddr;
+}
+
+/* Returns the queue for UADDR in the current address space, or a
+   null pointer if no thread is waiting on it.  futex_lock must be
+   held. */
+static struct futex_queue *futex_lookup(const int *uaddr) {
+    struct futex_queue key;
+    struct hash_elem *e;
+
+    key.pagedir = thread_current()->pagedir;
+    key.uaddr = uaddr;
+    e = hash_find(&futex_table, &key.elem);
+    return e != NULL ? hash_entry(e, struct futex_queue, elem) : NULL;
+}
+
+void futex_init(void) {
+    hash_init(&futex_table, futex_hash, futex_less, NULL);
+    lock_init(&futex_lock);
+    lock_set_name(&futex_lock, "futex");
+}
+
+/* Blocks the current thread until futex_wake() is called on
+   UADDR, provided *UADDR still equals EXPECTED.  The comparison
+   and the enqueue happen under futex_lock, so a waker that
+   changes the word and then calls futex_wake() cannot slip in
+   between them.  Returns 0 after being woken or -1 if the word
+   had already changed.  UADDR must have been validated. */
+int futex_wait(int *uaddr, int expected) {
+    struct futex_queue *q;
+    struct futex_waiter w;
+
+    lock_acquire(&futex_lock);
+    if (*uaddr != expected) {
+        lock_release(&futex_lock);
+        return -1;
+    }
+
+    q = futex_lookup(uaddr);
+    if (q == NULL) {
+        q = malloc(sizeof *q);
+        if (q == NULL) {
+            lock_release(&futex_lock);
+            return -1;
+        }
+        q->pagedir = thread_current()->pagedir;
+        q->uaddr = uaddr;
+        list_init(&q->waiters);
+        hash_insert(&futex_table, &q->elem);
+    }
+    sema_init(&w.sema, 0);
+    list_push_back(&q->waiters, &w.elem);
+    lock_release(&futex_lock);
+
+    sema_down(&w.sema);
+    return 0;
+}
+
+/* Wakes up to N threads of the current process that are waiting
+   on UADDR, in FIFO order.  Returns the number woken. */
+int futex_wake(int *uaddr, int n) {
+    struct futex_queue *q;
+    int woken = 0;
+
+    lock_acquire(&futex_lock);
+    q = futex_lookup(uaddr);
+    if (q != NULL) {
+        while (woken < n && !list_empty(&q->waiters)) {
+            struct futex_waiter *w = list_entry(list_pop_front(&q->waiters),
+                                                struct futex_waiter, elem);
+            sema_up(&w->sema);
+            woken++;
+        }
+        if (list_empty(&q->waiters)) {
+            hash_delete(&futex_table, &q->elem);
+            free(q);
+        }
+    }
+    lock_release(&futex_lock);
+    return woken;
+}
@@ -0,0 +1,12 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+/* Fast user-space mutex support.  A process keeps its lock word
+   in its own memory and only enters the kernel to sleep when the
+   word shows contention, or to wake sleepers when it releases. */
+
+void futex_init(void);
+int futex_wait(int *uaddr, int expected);
+int futex_wake(int *uaddr, int n);
+
+#endif /* userprog/futex.h */
@@ -156,6 +156,16 @@ pagedir_clear_page (uint32_t *pd, void *upage)
     }
 }
 
+/* Returns true if PD maps virtual page VPAGE present, user
+   accessible, and writable, false otherwise. */
+bool
+pagedir_is_writable (uint32_t *pd, const void *vpage) 
+{
+  uint32_t *pte = lookup_page (pd, vpage, false);
+  uint32_t flags = PTE_P | PTE_U | PTE_W;
+  return pte != NULL && (*pte & flags) == flags;
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PD is dirty,
    that is, if the page has been modified since the PTE was
    installed.
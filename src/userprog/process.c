@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "userprog/fpu.h"
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
 #include "userprog/tss.h"
@@ -16,6 +17,7 @@
 #include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "userprog/syscall.h"
@@ -28,8 +30,19 @@ extern const int NOT_LOADED;
 extern const int LOAD_SUCCESS;
 extern const int LOAD_FAIL;
 
-/* boolean flag from thread.c */
-extern bool thread_alive;
+/* Process table: every child_process still held by its parent,
+   hashed by pid.  Also protects the reference counts and the
+   parent's child_list. */
+static struct hash process_table;
+static struct lock process_lock;
+
+/* Caches of open file records and child process records. */
+static struct kmem_cache *process_file_cache;
+static struct kmem_cache *child_process_cache;
+
+static hash_hash_func process_hash;
+static hash_less_func process_less;
+static void release_child_process(struct child_process *cp);
 
 #define MAX_FD 128  // Maximum number of file descriptors per process
 
@@ -139,25 +152,25 @@ process_exit (void)
 	uint32_t *pd;
 
 	/* closing all files which were opened by the process */
-	lock_acquire(&filesys_lock);
+	rw_write_acquire(&filesys_lock);
 	current_process_close_file(CLOSE_ALL, thread_current());
 	if (cur->executable){
 		file_close(cur->executable);
 	}
-	lock_release(&filesys_lock);
+	rw_write_release(&filesys_lock);
 
-	/* remove all child from child list and update state */
+	/* remove all child from child list and update state.  Our
+	   reference keeps our own record alive even if the parent has
+	   already exited. */
 	remove_children(thread_current());
-	enum intr_level old_level = intr_disable();
-	thread_foreach(is_thread_alive, (void *) cur->parent);
-	if (thread_alive){
-		if (cur->cp && cur->executable){
-			cur->cp->exit = true;
-			sema_up(&cur->cp->exit_sema);
-		}
+	if (cur->cp){
+		cur->cp->exit = true;
+		sema_up(&cur->cp->exit_sema);
+		release_child_process(cur->cp);
+		cur->cp = NULL;
 	}
-	flag_reset();
-	intr_set_level(old_level);
+
+	fpu_release (cur);
 
 	/* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
@@ -284,7 +297,7 @@ load (const char *file_name, void (**eip) (void), void **esp, char **save_ptr)
 	process_activate ();
 
 	/* Open executable file. */
-	lock_acquire(&filesys_lock);
+	rw_write_acquire(&filesys_lock);
 	file = filesys_open (file_name);
 	if (file == NULL)
 	{
@@ -377,7 +390,7 @@ load (const char *file_name, void (**eip) (void), void **esp, char **save_ptr)
 
 	done:
 	/* We arrive here whether the load is successful or not. */
-	lock_release(&filesys_lock);
+	rw_write_release(&filesys_lock);
 	return success;
 }
 
@@ -590,7 +603,7 @@ install_page (void *upage, void *kpage, bool writable)
 int
 current_process_add_file(struct file *f, struct thread *t) 
 {
-    struct process_file *pf = malloc(sizeof(struct process_file));
+    struct process_file *pf = kmem_cache_alloc(process_file_cache);
 
     if (!pf)
         return ERROR;
@@ -599,7 +612,7 @@ current_process_add_file(struct file *f, struct thread *t)
 
 	/* Ensuring file descriptors don't exceed a limit */
     if (t->fd >= MAX_FD) {
-        free(pf);
+        kmem_cache_free(process_file_cache, pf);
         return ERROR;
     }
 
@@ -644,7 +657,7 @@ current_process_close_file(int fd, struct thread *t)
         if (pf != NULL && (fd == pf->fd || fd == CLOSE_ALL)) {
             file_close(pf->file);
             list_remove(&pf->elem);
-            free(pf);
+            kmem_cache_free(process_file_cache, pf);
 
             if (fd != CLOSE_ALL) 
                 break; // If not closing all files, stop after the match.
@@ -653,46 +666,112 @@ current_process_close_file(int fd, struct thread *t)
     }
 }
 
-/* Add a new child process with the given PID to the parent thread. */
+/* Initializes the process table. */
 void
+process_init(void) 
+{
+    hash_init(&process_table, process_hash, process_less, NULL);
+    lock_init(&process_lock);
+    lock_set_name(&process_lock, "process");
+    process_file_cache = kmem_cache_create("process_file",
+                                           sizeof(struct process_file), NULL);
+    child_process_cache = kmem_cache_create("child_process",
+                                            sizeof(struct child_process), NULL);
+}
+
+/* Returns a hash value for child_process E. */
+static unsigned
+process_hash(const struct hash_elem *e, void *aux UNUSED) 
+{
+    return hash_int(hash_entry(e, struct child_process, hash_elem)->pid);
+}
+
+/* Returns true if child_process A has a lower pid than B. */
+static bool
+process_less(const struct hash_elem *a, const struct hash_elem *b,
+             void *aux UNUSED) 
+{
+    return (hash_entry(a, struct child_process, hash_elem)->pid
+            < hash_entry(b, struct child_process, hash_elem)->pid);
+}
+
+/* Add a new child process with the given PID to the parent thread,
+   and return its record, holding one reference for the parent and
+   one for the child.  Returns a null pointer if out of memory. */
+struct child_process *
 add_child_process(int pid, struct thread *t) 
 {
-    struct child_process *cp = malloc(sizeof(struct child_process));
+    struct child_process *cp = kmem_cache_alloc(child_process_cache);
 
    if (!cp) {
-        return;
+        return NULL;
     }
 
     cp->pid = pid;
     cp->load = NOT_LOADED;
     cp->wait = false;
     cp->exit = false;
+    cp->parent = t->tid;
+    cp->ref_cnt = 2;
     sema_init(&cp->load_sema, 0);
     sema_init(&cp->exit_sema, 0);
+
+    lock_acquire(&process_lock);
     list_push_back(&t->child_list, &cp->elem);
+    hash_insert(&process_table, &cp->hash_elem);
+    lock_release(&process_lock);
+    return cp;
 }
 
-/* Retrieve the child process structure corresponding to the given PID. */
+/* Retrieve the child process structure corresponding to the given PID,
+   or a null pointer if PID is not a child of T. */
 struct child_process
 *get_child_process(int pid, struct thread *t) 
 {
-    for (struct list_elem *e = list_begin(&t->child_list); e != list_end(&t->child_list); e = list_next(e)) {
-        struct child_process *cp = list_entry(e, struct child_process, elem);
-        if (cp->pid == pid)
-            return cp;
-    }
-    return NULL;
+    struct child_process key, *cp = NULL;
+    struct hash_elem *e;
+
+    key.pid = pid;
+    lock_acquire(&process_lock);
+    e = hash_find(&process_table, &key.hash_elem);
+    if (e != NULL && hash_entry(e, struct child_process, hash_elem)->parent == t->tid)
+        cp = hash_entry(e, struct child_process, hash_elem);
+    lock_release(&process_lock);
+    return cp;
+}
+
+/* Drops a reference to CP, freeing it if that was the last one.
+   process_lock must be held. */
+static void
+put_child_process(struct child_process *cp) 
+{
+    ASSERT(cp->ref_cnt > 0);
+    if (--cp->ref_cnt == 0)
+        kmem_cache_free(child_process_cache, cp);
+}
+
+/* Drops the parent's reference to CP: removes CP from its parent's
+   child list and the process table. */
+static void
+unlink_child_process(struct child_process *cp) 
+{
+    list_remove(&cp->elem);
+    hash_delete(&process_table, &cp->hash_elem);
+    cp->parent = TID_ERROR;
+    put_child_process(cp);
 }
 
-/* Remove the specified child process from the list and free its memory. */
+/* Remove the specified child process from the list and drop the
+   parent's reference to it. */
 void
 remove_child_process(struct child_process *cp) 
 {
     if (cp == NULL) 
         return; // Do nothing if child process is NULL.
 
-    list_remove(&cp->elem);
-    free(cp);
+    lock_acquire(&process_lock);
+    unlink_child_process(cp);
+    lock_release(&process_lock);
 }
 
 /* Remove all child processes associated with the given thread. */
@@ -702,13 +781,21 @@ remove_children(struct thread *t)
     if (t == NULL) 
         return; // Do nothing if thread is NULL.
 
+    lock_acquire(&process_lock);
     while (!list_empty(&t->child_list)) {
-        struct list_elem *e = list_pop_front(&t->child_list);
-        struct child_process *cp = list_entry(e, struct child_process, elem);
-
-        if (cp != NULL)
-            free(cp);
+        struct list_elem *e = list_front(&t->child_list);
+        unlink_child_process(list_entry(e, struct child_process, elem));
     }
+    lock_release(&process_lock);
+}
+
+/* Drops the child's reference to its own record CP. */
+static void
+release_child_process(struct child_process *cp) 
+{
+    lock_acquire(&process_lock);
+    put_child_process(cp);
+    lock_release(&process_lock);
 }
 
 /* Push final arguments onto the stack in the correct order. */
@@ -1,5 +1,6 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
 #include "devices/input.h"
 #include "devices/shutdown.h"
@@ -8,6 +9,7 @@
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "userprog/pagedir.h"
+#include "userprog/futex.h"
 #include "userprog/syscall.h"
 
 /* Exit status constants */
@@ -18,7 +20,7 @@ const int LOAD_SUCCESS = 1;
 const int LOAD_FAIL = 2;
 
 /* Filesystem lock */
-struct lock filesys_lock;
+struct rwlock filesys_lock;
 
 /* Syscall usage metrics */
 static int syscall_usage[SYS_IPC_RECEIVE + 1] = {0}; // Tracks usage count of each syscall
@@ -32,7 +34,9 @@ static void track_syscall_usage(int syscall_code);
 
 /* Syscall initialization */
 void syscall_init(void) {
-    lock_init(&filesys_lock);
+    rw_init(&filesys_lock);
+    rw_set_name(&filesys_lock, "filesys");
+    futex_init();
     intr_register_int(0x30, 3, INTR_ON, syscall_handler, "syscall");
 }
 
@@ -82,9 +86,14 @@ static int num_syscall_args(int syscall_code) {
         case SYS_FILESIZE:
         case SYS_TELL:
         case SYS_CLOSE:
+        case SYS_SCHEDSTAT:
             return 1;
         case SYS_CREATE:
         case SYS_SEEK:
+        case SYS_FUTEX_WAIT:
+        case SYS_FUTEX_WAKE:
+        case SYS_INTRSTAT:
+        case SYS_SET_DEADLINE:
             return 2;
         case SYS_READ:
         case SYS_WRITE:
@@ -124,6 +133,42 @@ void validate_buffer(void *buffer, unsigned size) {
     }
 }
 
+/* Copy SIZE bytes from kernel buffer SRC to user address UDST.
+   Every page of the destination must be mapped present, user and
+   writable; otherwise the process is terminated before anything is
+   written.  The copy goes through the kernel alias of each page, so
+   it cannot fault. */
+void copy_to_user(void *udst, const void *src, size_t size) {
+    uint32_t *pd = thread_current()->pagedir;
+    uint8_t *dst = udst;
+    const uint8_t *s = src;
+    size_t ofs;
+
+    if (size == 0) {
+        return;
+    }
+    if (dst == NULL || !is_user_vaddr(dst) || !is_user_vaddr(dst + size - 1)
+        || dst + size - 1 < dst) {
+        terminate_process(ERROR);
+    }
+    for (ofs = 0; ofs < size; ofs += PGSIZE - pg_ofs(dst + ofs)) {
+        if (!pagedir_is_writable(pd, pg_round_down(dst + ofs))) {
+            terminate_process(ERROR);
+        }
+    }
+
+    while (size > 0) {
+        size_t chunk = PGSIZE - pg_ofs(dst);
+        if (chunk > size) {
+            chunk = size;
+        }
+        memcpy(pagedir_get_page(pd, dst), s, chunk);
+        dst += chunk;
+        s += chunk;
+        size -= chunk;
+    }
+}
+
 /* Validate a user-provided string */
 void validate_string(const void *str) {
     for (const char *s = (const char *)str; is_valid_pointer(s) && *s != '\0'; s++) {
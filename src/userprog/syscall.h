@@ -16,7 +16,7 @@ typedef int pid_t;
 #define SYS_IPC_RECEIVE 101 /* Code for receiving IPC messages */
 #define SYSCALL_MAX 20 // Maximum number of syscalls to track
 /* Filesystem lock (shared across files) */
-extern struct lock filesys_lock;
+extern struct rwlock filesys_lock;
 
 /* Common constants for syscall handling */
 extern const int CLOSE_ALL;    /* Special file descriptor to close all files */
@@ -67,6 +67,7 @@ int convert_user_vaddr(const void *vaddr);       // Replaces `conv_vaddr`
 bool is_valid_pointer(const void *vaddr);        // Replaces `verify_ptr`
 void validate_buffer(void *buffer, unsigned size); // Replaces `verify_buffer`
 void validate_string(const void *str);           // Replaces `verify_str`
+void copy_to_user(void *udst, const void *src, size_t size);
 
 #endif /* USERPROG_SYSCALL_H */
 
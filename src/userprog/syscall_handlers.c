@@ -8,6 +8,7 @@
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/synch.h"
+#include "userprog/futex.h"
 #include <stdio.h>
 
 /* Handle system calls with one argument */
@@ -66,6 +67,53 @@ void syscall_write(struct intr_frame *f, int *arg) {
     f->eax = write_to_file(arg[0], (const void *)arg[1], (unsigned)arg[2]); // Renamed from `write`
 }
 
+void syscall_schedstat(struct intr_frame *f, int *arg) {
+    /* Gather the statistics in kernel memory, then copy them out
+       only to pages the process may write. */
+    struct schedstat st;
+
+    thread_get_schedstat(&st);
+    copy_to_user((void *)arg[0], &st, sizeof st);
+    f->eax = true;
+}
+
+/* Checks that a futex word is aligned and lies in user memory,
+   terminating the process if it does not. */
+static void validate_futex(const void *uaddr) {
+    if ((uintptr_t)uaddr % sizeof(int) != 0) {
+        terminate_process(ERROR);
+    }
+    validate_buffer((void *)uaddr, sizeof(int));
+}
+
+void syscall_futex_wait(struct intr_frame *f, int *arg) {
+    validate_futex((const void *)arg[0]);
+    f->eax = futex_wait((int *)arg[0], arg[1]);
+}
+
+void syscall_futex_wake(struct intr_frame *f, int *arg) {
+    validate_futex((const void *)arg[0]);
+    f->eax = futex_wake((int *)arg[0], arg[1]);
+}
+
+void syscall_intrstat(struct intr_frame *f, int *arg) {
+    if (arg[0] < 0 || arg[0] >= INTRSTAT_VECTORS) {
+        f->eax = false;
+        return;
+    }
+    /* Fill a kernel copy first: intr_get_stats stores with
+       interrupts off, where a fault on a user page would panic. */
+    struct intrstat st;
+
+    intr_get_stats(arg[0], &st);
+    copy_to_user((void *)arg[1], &st, sizeof st);
+    f->eax = true;
+}
+
+void syscall_set_deadline(struct intr_frame *f, int *arg) {
+    f->eax = thread_set_deadline(arg[0], arg[1]);
+}
+
 static const struct syscall_mapping syscall_map[] = {
     {SYS_EXIT, syscall_exit},
     {SYS_EXEC, syscall_exec},
@@ -78,6 +126,11 @@ static const struct syscall_mapping syscall_map[] = {
     {SYS_SEEK, syscall_seek},
     {SYS_READ, syscall_read},
     {SYS_WRITE, syscall_write},
+    {SYS_SCHEDSTAT, syscall_schedstat},
+    {SYS_FUTEX_WAIT, syscall_futex_wait},
+    {SYS_FUTEX_WAKE, syscall_futex_wake},
+    {SYS_INTRSTAT, syscall_intrstat},
+    {SYS_SET_DEADLINE, syscall_set_deadline},
     // Add more syscalls as needed.
 };
 void call_syscall_handler(int syscall_code, struct intr_frame *f, int *arg) {
@@ -112,29 +165,44 @@ static void syscall_handler(struct intr_frame *f) {
 static struct file *fetch_file_with_lock(int fd, struct thread *cur_thread) {
     struct file *file_ptr = current_process_get_file(fd, cur_thread);
     if (file_ptr != NULL) {
-        lock_acquire(&filesys_lock);
+        rw_write_acquire(&filesys_lock);
     }
     return file_ptr;
 }
 
 static void unlock_file_lock() {
-    lock_release(&filesys_lock);
+    rw_write_release(&filesys_lock);
+}
+
+/* Like fetch_file_with_lock(), but only takes filesys_lock for
+   reading, so calls that don't modify the file system can run
+   in parallel. */
+static struct file *fetch_file_for_read(int fd, struct thread *cur_thread) {
+    struct file *file_ptr = current_process_get_file(fd, cur_thread);
+    if (file_ptr != NULL) {
+        rw_read_acquire(&filesys_lock);
+    }
+    return file_ptr;
+}
+
+static void unlock_file_read_lock(void) {
+    rw_read_release(&filesys_lock);
 }
 
 static int perform_file_operation(struct file *file_ptr, int (*operation)(struct file *, const void *, unsigned),
                                  const void *buffer, unsigned size) {
     if (file_ptr == NULL) return ERROR;
-    lock_acquire(&filesys_lock);
+    rw_write_acquire(&filesys_lock);
     int result = operation(file_ptr, buffer, size);
-    lock_release(&filesys_lock);
+    rw_write_release(&filesys_lock);
     return result;
 }
 
 static bool execute_file_action(struct file *file_ptr, void (*action)(struct file *)) {
     if (file_ptr == NULL) return false;
-    lock_acquire(&filesys_lock);
+    rw_write_acquire(&filesys_lock);
     action(file_ptr);
-    lock_release(&filesys_lock);
+    rw_write_release(&filesys_lock);
     return true;
 }
 
@@ -174,34 +242,34 @@ int wait_for_program(pid_t process_id) {
 }
 
 bool create_file(const char *filename, unsigned initial_size) {
-    lock_acquire(&filesys_lock);
+    rw_write_acquire(&filesys_lock);
     bool success = filesys_create(filename, initial_size);
-    lock_release(&filesys_lock);
+    rw_write_release(&filesys_lock);
     return success;
 }
 
 bool delete_file(const char *filename) {
-    lock_acquire(&filesys_lock);
+    rw_write_acquire(&filesys_lock);
     bool success = filesys_remove(filename);
-    lock_release(&filesys_lock);
+    rw_write_release(&filesys_lock);
     return success;
 }
 
 int open_file(const char *filename) {
-    lock_acquire(&filesys_lock);
+    rw_write_acquire(&filesys_lock);
     struct file *file_ptr = filesys_open(filename);
     int result = (file_ptr != NULL) ?current_process_add_file(file_ptr, thread_current()) : ERROR;
-    lock_release(&filesys_lock);
+    rw_write_release(&filesys_lock);
     return result;
 }
 
 int get_file_size(int fd) {
     struct thread *current_thread = thread_current();
-    struct file *file_ptr = fetch_file_with_lock(fd, current_thread);
+    struct file *file_ptr = fetch_file_for_read(fd, current_thread);
     if (file_ptr == NULL) return ERROR;
 
     int length = file_length(file_ptr);
-    unlock_file_lock();
+    unlock_file_read_lock();
     return length;
 }
 
@@ -215,11 +283,11 @@ int read_from_file(int fd, void *buffer, unsigned size) {
         return size;
     }
 
-    struct file *file_ptr = fetch_file_with_lock(fd, current_thread);
+    struct file *file_ptr = fetch_file_for_read(fd, current_thread);
     if (file_ptr == NULL) return ERROR;
 
     int bytes_read = file_read(file_ptr, buffer, size);
-    unlock_file_lock();
+    unlock_file_read_lock();
     return bytes_read;
 }
 
@@ -249,19 +317,19 @@ void set_file_position(int fd, unsigned position) {
 
 unsigned get_file_position(int fd) {
     struct thread *current_thread = thread_current();
-    struct file *file_ptr = fetch_file_with_lock(fd, current_thread);
+    struct file *file_ptr = fetch_file_for_read(fd, current_thread);
     if (file_ptr == NULL) return ERROR;
 
     unsigned position = file_tell(file_ptr);
-    unlock_file_lock();
+    unlock_file_read_lock();
     return position;
 }
 
 void close_file(int fd) {
     struct thread *current_thread = thread_current();
-    lock_acquire(&filesys_lock);
+    rw_write_acquire(&filesys_lock);
     current_process_close_file(fd, current_thread);
-    lock_release(&filesys_lock);
+    rw_write_release(&filesys_lock);
 }
 int syscall_usage_count[20] = {0};
 